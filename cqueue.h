@@ -0,0 +1,140 @@
+// PingPongOS - PingPong Operating System
+
+// Fila contada: a mesma lista circular de queue.h (os elementos comecam com
+// os ponteiros prev e next), com operacoes inline O(1) e uma cabeca que
+// guarda o numero de elementos, para que o tamanho nao exija percorrer a
+// lista.
+//
+// As verificacoes de queue.h (elemento ja em outra fila, elemento fora da
+// fila indicada) percorrem a lista; aqui elas so sao compiladas com
+// QUEUE_DEBUG (ou DEBUG) definido. Sem elas, usar a fila errada corrompe as
+// listas em silencio.
+//
+// As funcoes ring_* operam sobre uma cabeca simples (queue_t *), como as
+// filas do nucleo (readyQueue, sleepQueue, filas dos semaforos), que nao
+// podem mudar de tipo; as cqueue_* mantem tambem a contagem.
+
+#ifndef __CQUEUE__
+#define __CQUEUE__
+
+#include "queue.h"
+
+#if defined(DEBUG) && !defined(QUEUE_DEBUG)
+#define QUEUE_DEBUG
+#endif
+
+#ifdef QUEUE_DEBUG
+#include <stdio.h>
+#endif
+
+// fila contada
+typedef struct
+{
+   queue_t *head ;	// primeiro elemento, ou NULL (como uma fila de queue.h)
+   int count ;		// numero de elementos
+} cqueue_t ;
+
+#define CQUEUE_INIT { NULL, 0 }
+
+#ifdef QUEUE_DEBUG
+// indica se elem esta na lista circular que comeca em head
+static inline int ring_contains (queue_t *head, queue_t *elem)
+{
+   queue_t *aux = head ;
+
+   if (aux)
+      do {
+         if (aux == elem)
+            return (1) ;
+         aux = aux->next ;
+      } while (aux != head) ;
+   return (0) ;
+}
+#endif
+
+// insere elem, que nao pode estar em fila alguma, no fim da lista. Retorna
+// 0, ou -1 se a verificacao (QUEUE_DEBUG) falhar
+static inline int ring_append (queue_t **ring, queue_t *elem)
+{
+#ifdef QUEUE_DEBUG
+   if (!ring || !elem || elem->prev || elem->next) {
+      fprintf (stderr, "### ring_append: elemento invalido ou em outra fila\n") ;
+      return (-1) ;
+   }
+#endif
+   if (*ring) {
+      elem->next = *ring ;
+      elem->prev = (*ring)->prev ;
+      (*ring)->prev->next = elem ;
+      (*ring)->prev = elem ;
+   }
+   else {
+      elem->prev = elem->next = elem ;
+      *ring = elem ;
+   }
+   return (0) ;
+}
+
+// retira elem da lista e zera os seus ponteiros. Retorna elem, ou NULL se a
+// verificacao (QUEUE_DEBUG) falhar
+static inline queue_t *ring_remove (queue_t **ring, queue_t *elem)
+{
+#ifdef QUEUE_DEBUG
+   if (!ring || !elem || !ring_contains (*ring, elem)) {
+      fprintf (stderr, "### ring_remove: elemento fora da fila\n") ;
+      return (NULL) ;
+   }
+#endif
+   if (elem->next == elem)
+      *ring = NULL ;
+   else {
+      elem->prev->next = elem->next ;
+      elem->next->prev = elem->prev ;
+      if (*ring == elem)
+         *ring = elem->next ;
+   }
+   elem->prev = elem->next = NULL ;
+   return (elem) ;
+}
+
+static inline void cqueue_init (cqueue_t *q)
+{
+   q->head = NULL ;
+   q->count = 0 ;
+}
+
+// numero de elementos, sem percorrer a lista
+static inline int cqueue_size (cqueue_t *q)
+{
+   return (q->count) ;
+}
+
+// primeiro elemento, sem retira-lo, ou NULL se a fila estiver vazia
+static inline queue_t *cqueue_first (cqueue_t *q)
+{
+   return (q->head) ;
+}
+
+static inline int cqueue_append (cqueue_t *q, queue_t *elem)
+{
+   if (ring_append (&q->head, elem) < 0)
+      return (-1) ;
+   q->count++ ;
+   return (0) ;
+}
+
+static inline queue_t *cqueue_remove (cqueue_t *q, queue_t *elem)
+{
+   if (!ring_remove (&q->head, elem))
+      return (NULL) ;
+   q->count-- ;
+   return (elem) ;
+}
+
+// retira e retorna o primeiro elemento, ou NULL se a fila estiver vazia
+static inline queue_t *cqueue_pop (cqueue_t *q)
+{
+   return (q->head ? cqueue_remove (q, q->head) : NULL) ;
+}
+
+#endif
@@ -0,0 +1,204 @@
+// PingPongOS - PingPong Operating System
+
+// Heap de minimo generico e intrusivo, para quem precisa escolher o menor
+// elemento por uma chave (escalonadores, escalonador de disco): o elemento
+// embute um heapnode_t, que guarda a sua posicao, e o heap guarda apenas
+// ponteiros para os nos em um vetor. Inserir, retirar o menor, retirar um
+// no qualquer e reposicionar um no cuja chave mudou custam O(log n).
+//
+// O heap e d-ario, com HEAP_ARITY filhos por no. Um heap 4-ario e mais
+// baixo, mas faz mais comparacoes na descida, e aqui cada uma e uma chamada
+// por ponteiro: em pingpong-bench-heap o binario foi mais rapido, e e o
+// padrao. A ordem e dada pela funcao before do heap; com uma ordem total
+// (p.ex. chave e ordem de chegada nos empates), a sequencia de retiradas
+// nao depende da aridade.
+//
+// As verificacoes de pertinencia so sao compiladas com QUEUE_DEBUG (ou
+// DEBUG) definido, como em cqueue.h.
+
+#ifndef __HEAP__
+#define __HEAP__
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#if defined(DEBUG) && !defined(QUEUE_DEBUG)
+#define QUEUE_DEBUG
+#endif
+
+#ifdef QUEUE_DEBUG
+#include <stdio.h>
+#endif
+
+#ifndef HEAP_ARITY
+#define HEAP_ARITY 2
+#endif
+
+// no embutido no elemento
+typedef struct heapnode_t
+{
+   int index ;			// posicao no vetor do heap
+} heapnode_t ;
+
+typedef struct heap_t
+{
+   heapnode_t **node ;		// vetor de nos, o menor na posicao 0
+   int size ;			// nos no heap
+   int max ;			// capacidade alocada
+   int (*before) (heapnode_t *a, heapnode_t *b) ;	// 1 se a sai antes de b
+} heap_t ;
+
+#define HEAP_INIT(before) { NULL, 0, 0, (before) }
+
+// elemento do tipo type que contem o no ptr no campo member
+#define heap_entry(ptr, type, member) \
+   ((type *) ((char *) (ptr) - offsetof (type, member)))
+
+static inline void heap_init (heap_t *h, int (*before) (heapnode_t *, heapnode_t *))
+{
+   h->node = NULL ;
+   h->size = h->max = 0 ;
+   h->before = before ;
+}
+
+// libera o vetor; os nos nao sao tocados
+static inline void heap_free (heap_t *h)
+{
+   free (h->node) ;
+   h->node = NULL ;
+   h->size = h->max = 0 ;
+}
+
+// esvazia o heap, mantendo o vetor
+static inline void heap_clear (heap_t *h)
+{
+   h->size = 0 ;
+}
+
+static inline int heap_size (heap_t *h)
+{
+   return (h->size) ;
+}
+
+// menor no, sem retira-lo, ou NULL se o heap estiver vazio
+static inline heapnode_t *heap_first (heap_t *h)
+{
+   return (h->size ? h->node[0] : NULL) ;
+}
+
+// indica se o no esta no heap (nao exige inicializar o no)
+static inline int heap_contains (heap_t *h, heapnode_t *node)
+{
+   return (node->index >= 0 && node->index < h->size &&
+           h->node[node->index] == node) ;
+}
+
+static inline void heap_place (heap_t *h, int i, heapnode_t *node)
+{
+   h->node[i] = node ;
+   node->index = i ;
+}
+
+// sobe o no da posicao i ate a sua posicao no heap
+static inline void heap_sift_up (heap_t *h, int i)
+{
+   heapnode_t *node = h->node[i] ;
+   int parent ;
+
+   while (i > 0 && h->before (node, h->node[parent = (i - 1) / HEAP_ARITY])) {
+      heap_place (h, i, h->node[parent]) ;
+      i = parent ;
+   }
+   heap_place (h, i, node) ;
+}
+
+// desce o no da posicao i ate a sua posicao no heap
+static inline void heap_sift_down (heap_t *h, int i)
+{
+   heapnode_t *node = h->node[i] ;
+   int child, last, best ;
+
+   while ((child = HEAP_ARITY * i + 1) < h->size) {
+      last = child + HEAP_ARITY < h->size ? child + HEAP_ARITY : h->size ;
+      for (best = child++; child < last; child++)
+         if (h->before (h->node[child], h->node[best]))
+            best = child ;
+      if (!h->before (h->node[best], node))
+         break ;
+      heap_place (h, i, h->node[best]) ;
+      i = best ;
+   }
+   heap_place (h, i, node) ;
+}
+
+// insere o no; retorna 0, ou -1 se faltar memoria para o vetor
+static inline int heap_insert (heap_t *h, heapnode_t *node)
+{
+   if (h->size == h->max) {
+      int max = h->max ? 2 * h->max : 64 ;
+      heapnode_t **n = realloc (h->node, max * sizeof (heapnode_t *)) ;
+      if (!n)
+         return (-1) ;
+      h->node = n ;
+      h->max = max ;
+   }
+   heap_place (h, h->size++, node) ;
+   heap_sift_up (h, node->index) ;
+   return (0) ;
+}
+
+// retira o no, que pode estar em qualquer posicao; retorna o no, ou NULL
+// se a verificacao (QUEUE_DEBUG) falhar
+static inline heapnode_t *heap_remove (heap_t *h, heapnode_t *node)
+{
+   heapnode_t *last ;
+   int i = node->index ;
+
+#ifdef QUEUE_DEBUG
+   if (!heap_contains (h, node)) {
+      fprintf (stderr, "### heap_remove: no fora do heap\n") ;
+      return (NULL) ;
+   }
+#endif
+   last = h->node[--h->size] ;
+   node->index = -1 ;
+   if (i < h->size) {
+      heap_place (h, i, last) ;
+      heap_sift_up (h, i) ;
+      heap_sift_down (h, last->index) ;
+   }
+   return (node) ;
+}
+
+// retira e retorna o menor no, ou NULL se o heap estiver vazio
+static inline heapnode_t *heap_pop (heap_t *h)
+{
+   return (h->size ? heap_remove (h, h->node[0]) : NULL) ;
+}
+
+// reposiciona o no cuja chave diminuiu (decrease-key)
+static inline void heap_decrease (heap_t *h, heapnode_t *node)
+{
+#ifdef QUEUE_DEBUG
+   if (!heap_contains (h, node)) {
+      fprintf (stderr, "### heap_decrease: no fora do heap\n") ;
+      return ;
+   }
+#endif
+   heap_sift_up (h, node->index) ;
+}
+
+// reposiciona o no cuja chave mudou em qualquer sentido
+static inline void heap_update (heap_t *h, heapnode_t *node)
+{
+#ifdef QUEUE_DEBUG
+   if (!heap_contains (h, node)) {
+      fprintf (stderr, "### heap_update: no fora do heap\n") ;
+      return ;
+   }
+#endif
+   heap_sift_up (h, node->index) ;
+   heap_sift_down (h, node->index) ;
+}
+
+#endif
@@ -0,0 +1,67 @@
+#!/bin/sh
+# PingPongOS - PingPong Operating System
+
+# Compila com -O2 cada teste pingpong-*.c que tem saida esperada (.txt),
+# junto com as fontes ppos-*.c e os objetos pre-compilados do nucleo, e
+# compara a saida de cada um com o seu .txt. Uso, no diretorio das fontes:
+#
+#    sh pingpong-O2.sh [opcoes extras do gcc]
+#
+# p.ex. "sh pingpong-O2.sh -DPPOS_ASM_CONTEXT". Os testes executam em um
+# diretorio temporario, com uma copia de disk.dat, por ate TIMEOUT s cada.
+# Imprime OK, DIFERE, ERRO (saida com codigo diferente de zero ou prazo
+# esgotado) ou COMPILACAO para cada teste.
+#
+# Resultado com -O2, com e sem -DPPOS_ASM_CONTEXT:
+#
+#    OK: future, group, many-tasks, scheduler, stack-pool, timed, timer,
+#        tls
+#
+#    DIFERE tambem com -O0, pois a saida esperada depende da maquina ou foi
+#    gerada por outra versao do teste, do nucleo ou do disco:
+#    - semaphore: instantes de systime() a 1 ms dos esperados;
+#    - barrier: outros tempos de sono e os instantes de cada tarefa;
+#    - mqueue: valores sorteados e intercalacao das tarefas;
+#    - racecond: intercalacao das tarefas e o texto inicial do teste;
+#    - preempcao, preempcao-stress: intercalacao pela preempcao por tempo;
+#    - contab-prio: instantes de inicio e fim de cada tarefa;
+#    - disco1, disco2: conteudo dos blocos do disk.dat e os relatorios
+#      de task_exit do nucleo que gerou o .txt;
+#    - scheduler-srtf: contagens da calibracao e mensagens daquele nucleo;
+#      a ordem e os instantes de inicio e fim sao os do .txt.
+#
+#    Com -O2, o compilador elimina os lacos vazios de hardwork() em
+#    contab-prio, preempcao e preempcao-stress: as tarefas terminam sem
+#    ser preemptadas. Os testes originais nao sao alterados para evitar
+#    isso.
+
+TIMEOUT=${TIMEOUT:-60}
+SRC=$(pwd)
+DIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$DIR"' EXIT
+
+for txt in pingpong-*.txt ; do
+   test=${txt%.txt}
+   [ -f "$test.c" ] || continue
+
+   if ! gcc -O2 "$@" -o "$DIR/$test" "$test.c" ppos-*.c \
+        ppos-all.o queue.o disk-driver.o -lm 2> "$DIR/$test.err" ; then
+      echo "$test: COMPILACAO"
+      continue
+   fi
+
+   # testes que pedem uma politica de escalonamento
+   case $test in
+      pingpong-scheduler-srtf) env="PPOS_CPU_SCHED=SRTF" ;;
+      *) env="" ;;
+   esac
+
+   cp "$SRC/disk.dat" "$DIR"
+   if ! (cd "$DIR" && env $env timeout "$TIMEOUT" "./$test" > "$test.out" 2>&1) ; then
+      echo "$test: ERRO"
+   elif cmp -s "$DIR/$test.out" "$txt" ; then
+      echo "$test: OK"
+   else
+      echo "$test: DIFERE"
+   fi
+done
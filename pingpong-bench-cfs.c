@@ -0,0 +1,109 @@
+// PingPongOS - PingPong Operating System
+
+// Benchmark de tempo de resposta do escalonador: tarefas de lote executam
+// trechos de processamento e cedem o processador; uma tarefa interativa
+// espera eventos em um semaforo e mede o tempo entre o evento e o momento
+// em que volta a executar. Executar com PPOS_CPU_SCHED=FIFO, CFS, MLFQ...
+// para comparar as politicas.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ppos.h"
+
+#define NUMBATCH 8		// tarefas de lote
+#define EVENTS   5000		// eventos tratados pela tarefa interativa
+#define WORK     20000		// processamento por vez de uma tarefa de lote (ns)
+
+task_t batch[NUMBATCH], inter ;
+semaphore_t event ;
+volatile int waiting, done ;	// tarefa interativa esperando / terminou
+long long posted ;		// instante do ultimo evento
+long long latency[EVENTS] ;	// tempos de resposta medidos
+
+long long now_ns ()
+{
+   struct timespec ts ;
+
+   clock_gettime (CLOCK_MONOTONIC, &ts) ;
+   return (ts.tv_sec * 1000000000LL + ts.tv_nsec) ;
+}
+
+// processa por ns nanossegundos
+void work (long long ns)
+{
+   long long end = now_ns () + ns ;
+
+   while (now_ns () < end) ;
+}
+
+// a tarefa 0 de lote tambem gera os eventos, a cada 4 vezes que executa
+void BatchBody (void * arg)
+{
+   long n = (long) arg ;
+   int turn ;
+
+   for (turn = 0; !done; turn++)
+   {
+      work (WORK) ;
+      if (n == 0 && waiting && turn % 4 == 0)
+      {
+         waiting = 0 ;
+         posted = now_ns () ;
+         sem_up (&event) ;
+      }
+      task_yield () ;
+   }
+   task_exit (0) ;
+}
+
+void InterBody (void * arg)
+{
+   int i ;
+
+   for (i = 0; i < EVENTS; i++)
+   {
+      waiting = 1 ;
+      sem_down (&event) ;
+      latency[i] = now_ns () - posted ;
+      work (WORK / 10) ;
+   }
+   done = 1 ;
+   task_exit (0) ;
+}
+
+int compare (const void *a, const void *b)
+{
+   long long x = *(long long *) a, y = *(long long *) b ;
+
+   return (x > y) - (x < y) ;
+}
+
+int main (int argc, char *argv[])
+{
+   long i ;
+
+   printf ("main: inicio\n") ;
+
+   ppos_init () ;
+
+   sem_create (&event, 0) ;
+   for (i = 0; i < NUMBATCH; i++)
+      task_create (&batch[i], BatchBody, (void *) i) ;
+   task_create (&inter, InterBody, NULL) ;
+
+   task_join (&inter) ;
+   for (i = 0; i < NUMBATCH; i++)
+      task_join (&batch[i]) ;
+
+   qsort (latency, EVENTS, sizeof (long long), compare) ;
+   printf ("%-4s, %d tarefas de lote: tempo de resposta em us: "
+           "p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+           ppos_sched_name (), NUMBATCH,
+           latency[EVENTS / 2] / 1000.0, latency[EVENTS * 9 / 10] / 1000.0,
+           latency[EVENTS * 99 / 100] / 1000.0, latency[EVENTS - 1] / 1000.0) ;
+
+   sem_destroy (&event) ;
+   printf ("main: fim\n") ;
+   exit (0) ;
+}
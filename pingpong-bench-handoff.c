@@ -0,0 +1,122 @@
+// PingPongOS - PingPong Operating System
+
+// Benchmark da passagem direta (ppos_handoff): mede a latencia entre a
+// liberacao de um semaforo ou mutex e o inicio da execucao da tarefa que
+// esperava por ele, com e sem passagem direta, e quantas trocas de contexto
+// (systime) cada passagem custa.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ppos.h"
+
+#define ROUNDS 200000
+
+task_t Ping, Pong ;
+semaphore_t sPing, sPong ;
+mutex_t m ;
+task_t *releaser ;	// tarefa que fez a ultima liberacao
+long long released ;	// instante da ultima liberacao
+long long latency ;	// soma das latencias medidas
+long passes ;		// numero de passagens medidas
+
+long long now_ns ()
+{
+   struct timespec ts ;
+
+   clock_gettime (CLOCK_MONOTONIC, &ts) ;
+   return (ts.tv_sec * 1000000000LL + ts.tv_nsec) ;
+}
+
+// anota a liberacao feita pela tarefa self
+void release (task_t *self)
+{
+   releaser = self ;
+   released = now_ns () ;
+}
+
+// registra a latencia desde a liberacao feita pela outra tarefa
+void woken (task_t *self)
+{
+   if (!releaser || releaser == self)
+      return ;
+   latency += now_ns () - released ;
+   passes++ ;
+}
+
+// semaforos: cada tarefa acorda a outra e espera ser acordada
+void SemBody (void * arg)
+{
+   semaphore_t *mine = (arg == &Ping) ? &sPing : &sPong ;
+   semaphore_t *other = (arg == &Ping) ? &sPong : &sPing ;
+   int i ;
+
+   for (i = 0; i < ROUNDS; i++)
+   {
+      sem_down (mine) ;
+      woken (arg) ;
+      release (arg) ;
+      sem_up (other) ;
+   }
+   task_exit (0) ;
+}
+
+// mutex: a tarefa libera o processador dentro da secao critica, de forma
+// que a outra sempre encontra o mutex ocupado e espera por ele
+void MutexBody (void * arg)
+{
+   int i ;
+
+   for (i = 0; i < ROUNDS; i++)
+   {
+      mutex_lock (&m) ;
+      woken (arg) ;
+      task_yield () ;
+      release (arg) ;
+      mutex_unlock (&m) ;
+   }
+   task_exit (0) ;
+}
+
+void run (char *name, void (*body)(void *), int handoff)
+{
+   unsigned int switches ;
+
+   ppos_handoff (handoff) ;
+   releaser = NULL ;
+   latency = passes = 0 ;
+   sem_create (&sPing, 0) ;
+   sem_create (&sPong, 0) ;
+   mutex_create (&m) ;
+
+   switches = systime () ;
+   task_create (&Ping, body, &Ping) ;
+   task_create (&Pong, body, &Pong) ;
+   sem_up (&sPing) ;
+   task_join (&Ping) ;
+   task_join (&Pong) ;
+   switches = systime () - switches ;
+
+   printf ("%-8s handoff %-3s: %ld passagens, %6.1f ns de latencia, %.2f trocas/passagem\n",
+           name, handoff ? "sim" : "nao", passes, (double) latency / passes,
+           (double) switches / passes) ;
+
+   sem_destroy (&sPing) ;
+   sem_destroy (&sPong) ;
+   mutex_destroy (&m) ;
+}
+
+int main (int argc, char *argv[])
+{
+   printf ("main: inicio\n") ;
+
+   ppos_init () ;
+
+   run ("semaforo", SemBody, 0) ;
+   run ("semaforo", SemBody, 1) ;
+   run ("mutex", MutexBody, 0) ;
+   run ("mutex", MutexBody, 1) ;
+
+   printf ("main: fim\n") ;
+   exit (0) ;
+}
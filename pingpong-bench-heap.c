@@ -0,0 +1,147 @@
+// PingPongOS - PingPong Operating System
+
+// Benchmark do heap de heap.h contra a busca linear em uma fila circular,
+// como a dos escalonadores e do escalonador de disco antes dele: n
+// elementos com chaves aleatorias, e a cada operacao o de menor chave e
+// retirado, recebe uma chave maior (como o passo do stride ou o prazo do
+// proximo periodo) e volta. As duas estruturas devem retirar os elementos
+// na mesma ordem. Compile com -DHEAP_ARITY=4 para comparar com um heap
+// 4-ario.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+#include "cqueue.h"
+#include "heap.h"
+
+#define MAXN 8192
+#define OPS  100000
+
+typedef struct item_t
+{
+   struct item_t *prev, *next ;		// fila circular
+   heapnode_t heap ;			// no no heap
+   unsigned long key ;
+   unsigned long seq ;			// desempate: ordem de chegada
+} item_t ;
+
+item_t item[MAXN] ;
+unsigned long arrivals ;
+unsigned int seed ;
+
+unsigned int lcg ()
+{
+   seed = seed * 1103515245 + 12345 ;
+   return (seed >> 8) ;
+}
+
+int item_before (item_t *a, item_t *b)
+{
+   if (a->key != b->key)
+      return (a->key < b->key) ;
+   return (a->seq < b->seq) ;
+}
+
+int node_before (heapnode_t *a, heapnode_t *b)
+{
+   return (item_before (heap_entry (a, item_t, heap),
+                        heap_entry (b, item_t, heap))) ;
+}
+
+// mesmas chaves iniciais para as duas estruturas
+void reset (int n)
+{
+   int i ;
+
+   seed = n ;
+   arrivals = 0 ;
+   for (i = 0; i < n; i++)
+   {
+      item[i].prev = item[i].next = NULL ;
+      item[i].key = lcg () % 1000 ;
+      item[i].seq = arrivals++ ;
+   }
+}
+
+// retira o menor elemento da fila percorrendo-a, e o devolve com nova chave
+unsigned long run_list (int n, unsigned long long *ns)
+{
+   queue_t *ring = NULL ;
+   item_t *min, *aux ;
+   unsigned long sum = 0 ;
+   unsigned long long start ;
+   int i ;
+
+   reset (n) ;
+   for (i = 0; i < n; i++)
+      ring_append (&ring, (queue_t *) &item[i]) ;
+
+   start = systime_ns () ;
+   for (i = 0; i < OPS; i++)
+   {
+      min = aux = (item_t *) ring ;
+      while ((aux = aux->next) != (item_t *) ring)
+         if (item_before (aux, min))
+            min = aux ;
+      ring_remove (&ring, (queue_t *) min) ;
+      sum = sum * 31 + (min - item) ;
+      min->key += 1 + lcg () % 1000 ;
+      min->seq = arrivals++ ;
+      ring_append (&ring, (queue_t *) min) ;
+   }
+   *ns = systime_ns () - start ;
+   return (sum) ;
+}
+
+// o mesmo com o heap
+unsigned long run_heap (int n, unsigned long long *ns)
+{
+   heap_t heap = HEAP_INIT (node_before) ;
+   item_t *min ;
+   unsigned long sum = 0 ;
+   unsigned long long start ;
+   int i ;
+
+   reset (n) ;
+   for (i = 0; i < n; i++)
+      heap_insert (&heap, &item[i].heap) ;
+
+   start = systime_ns () ;
+   for (i = 0; i < OPS; i++)
+   {
+      min = heap_entry (heap_pop (&heap), item_t, heap) ;
+      sum = sum * 31 + (min - item) ;
+      min->key += 1 + lcg () % 1000 ;
+      min->seq = arrivals++ ;
+      heap_insert (&heap, &min->heap) ;
+   }
+   *ns = systime_ns () - start ;
+   heap_free (&heap) ;
+   return (sum) ;
+}
+
+int main (int argc, char *argv[])
+{
+   unsigned long long list, heap ;
+   int n, errors = 0 ;
+
+   printf ("main: inicio\n") ;
+
+   ppos_init () ;
+
+   printf ("heap %d-ario, %d operacoes por tamanho\n", HEAP_ARITY, OPS) ;
+   for (n = 8; n <= MAXN; n *= 4)
+   {
+      if (run_list (n, &list) != run_heap (n, &heap))
+      {
+         printf ("n %5d: ordem de retirada DIFERENTE\n", n) ;
+         errors++ ;
+      }
+      printf ("n %5d: lista %8.1f ns/op, heap %6.1f ns/op (%.1fx)\n", n,
+              (double) list / OPS, (double) heap / OPS, (double) list / heap) ;
+   }
+   printf ("main: %d tamanhos com ordem de retirada diferente\n", errors) ;
+
+   printf ("main: fim\n") ;
+   exit (0) ;
+}
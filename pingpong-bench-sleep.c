@@ -0,0 +1,91 @@
+// PingPongOS - PingPong Operating System
+
+// Benchmark dos despertares: 100 mil tarefas com pilhas pequenas dormem de
+// 1 a 5 s (task_sleep) e, ao acordar, conferem que o prazo foi respeitado.
+// Uma tarefa relogio cede o processador ate todas acordarem, entao o
+// dispatcher passa por ela muitas vezes com as outras dormindo; o numero de
+// passagens por segundo mostra o custo de tratar as tarefas dormindo. O
+// argumento opcional muda o maior tempo de sono (em s).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ppos.h"
+
+#define NUMTASKS 100000
+
+task_t *task, ticker ;
+volatile int awake ;		// tarefas que ja acordaram
+int maxSleep = 5 ;		// maior tempo de sono (s)
+int early ;			// tarefas acordadas antes do prazo
+long rounds ;			// passagens da tarefa relogio
+long long elapsed ;		// duracao da tarefa relogio (ns)
+
+long long now_ns ()
+{
+   struct timespec ts ;
+
+   clock_gettime (CLOCK_MONOTONIC, &ts) ;
+   return (ts.tv_sec * 1000000000LL + ts.tv_nsec) ;
+}
+
+// corpo das tarefas: dorme e confere o instante do despertar
+void Body (void * arg)
+{
+   int t = (long) arg % maxSleep + 1 ;
+   unsigned int due = systime () + t * 1000 ;
+
+   task_sleep (t) ;
+   if ((int) (systime () - due) < 0)
+      early++ ;
+   awake++ ;
+   task_exit (0) ;
+}
+
+// mantem o dispatcher ocupado enquanto as tarefas dormem
+void ClockBody (void * arg)
+{
+   long long start = now_ns () ;
+
+   for (rounds = 0; awake < NUMTASKS; rounds++)
+      task_yield () ;
+   elapsed = now_ns () - start ;
+   task_exit (0) ;
+}
+
+int main (int argc, char *argv[])
+{
+   unsigned int wall, cpu ;
+   task_attr_t attr ;
+   long i ;
+
+   printf ("main: inicio\n") ;
+
+   if (argc > 1 && atoi (argv[1]) > 0)
+      maxSleep = atoi (argv[1]) ;
+
+   // cada pilha com guarda ocupa dois mapeamentos (ver pingpong-many-tasks.c)
+   setenv ("PPOS_STACK_GUARD", "0", 1) ;
+
+   ppos_init () ;
+
+   task = malloc (NUMTASKS * sizeof (task_t)) ;
+
+   task_attr_init (&attr) ;
+   attr.stackSize = PPOS_STACK_MIN ;
+   for (i = 0; i < NUMTASKS; i++)
+      task_create_attr (&task[i], Body, (void *) i, &attr) ;
+   task_create (&ticker, ClockBody, NULL) ;
+
+   for (i = 0; i < NUMTASKS; i++)
+      task_join (&task[i]) ;
+   task_join (&ticker) ;
+
+   ppos_idle_stats (&wall, NULL, &cpu) ;
+   printf ("main: %d tarefas acordadas, %d antes do prazo\n", awake, early) ;
+   printf ("main: %ld passagens do relogio em %lld ms (%.0f por segundo)\n",
+           rounds, elapsed / 1000000, elapsed ? rounds * 1e9 / elapsed : 0.0) ;
+   printf ("main: %u ms decorridos, %u ms de processador\n", wall, cpu) ;
+   printf ("main: fim\n") ;
+   exit (0) ;
+}
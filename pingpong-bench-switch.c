@@ -0,0 +1,62 @@
+// PingPongOS - PingPong Operating System
+
+// Benchmark da latencia de task_switch: duas tarefas trocam o processador
+// entre si diretamente, sem passar pelo dispatcher. Compile uma vez sem e
+// outra com -DPPOS_ASM_CONTEXT para comparar os dois backends de contexto.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ppos.h"
+#include "ppos-core-globals.h"
+#include "ppos-context.h"
+
+#define ROUNDS 1000000
+
+task_t Pong ;
+task_t *parked ;	// fila privada, tira Pong da fila de prontas
+
+// devolve o processador para main a cada troca recebida
+void BodyPong (void * arg)
+{
+   while (1)
+      task_switch (taskMain) ;
+}
+
+long long now_ns ()
+{
+   struct timespec ts ;
+
+   clock_gettime (CLOCK_MONOTONIC, &ts) ;
+   return (ts.tv_sec * 1000000000LL + ts.tv_nsec) ;
+}
+
+int main (int argc, char *argv[])
+{
+   long long start, elapsed ;
+   int i ;
+
+   printf ("main: inicio\n") ;
+
+   ppos_init () ;
+
+   task_create (&Pong, BodyPong, NULL) ;
+   task_suspend (&Pong, &parked) ;
+
+   // aquecimento (caches, paginas da pilha)
+   for (i = 0; i < 1000; i++)
+      task_switch (&Pong) ;
+
+   start = now_ns () ;
+   for (i = 0; i < ROUNDS; i++)
+      task_switch (&Pong) ;
+   elapsed = now_ns () - start ;
+
+   // cada volta sao duas trocas: main -> Pong -> main
+   printf ("backend %s: %d trocas em %lld us (%.1f ns/troca)\n",
+           context_backend (), 2 * ROUNDS, elapsed / 1000,
+           (double) elapsed / (2.0 * ROUNDS)) ;
+
+   printf ("main: fim\n") ;
+   exit (0) ;
+}
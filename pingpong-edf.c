@@ -0,0 +1,98 @@
+// PingPongOS - PingPong Operating System
+
+// Teste da classe de tempo real EDF: tres tarefas periodicas (utilizacao
+// total de 75%) executam trabalhos com metade do orcamento declarado, ao
+// lado de uma tarefa comum que so processa e cede o processador. Uma quarta
+// tarefa periodica pediria mais 50% do processador e deve ser recusada
+// pela admissao. No fim, cada tarefa periodica informa os trabalhos
+// concluidos e os prazos perdidos.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ppos.h"
+
+#define NUMRT 3
+#define JOBS  50		// trabalhos de cada tarefa periodica
+
+task_t rt[NUMRT], extra, hog ;
+int period[NUMRT] = { 10, 20, 40 } ;	// ms
+int budget[NUMRT] = {  2,  6, 14 } ;	// ms
+volatile int done ;			// tarefas periodicas encerradas
+
+long long now_ns ()
+{
+   struct timespec ts ;
+
+   clock_gettime (CLOCK_MONOTONIC, &ts) ;
+   return (ts.tv_sec * 1000000000LL + ts.tv_nsec) ;
+}
+
+// processa durante ms milissegundos
+void work (int ms)
+{
+   long long end = now_ns () + ms * 1000000LL ;
+
+   while (now_ns () < end) ;
+}
+
+void BodyRT (void * arg)
+{
+   int i, n = (long) arg ;
+
+   for (i=0; i<JOBS; i++)
+   {
+      work (budget[n] / 2) ;
+      task_rt_wait () ;
+   }
+   printf ("tarefa periodica %d (%2d/%2d ms): %d trabalhos, %d prazos perdidos\n",
+           n, budget[n], period[n], task_rt_jobs (NULL), task_rt_misses (NULL)) ;
+   done++ ;
+   task_exit (0) ;
+}
+
+void BodyExtra (void * arg)
+{
+   task_exit (0) ;
+}
+
+// tarefa comum: usa o processador que sobrar
+void BodyHog (void * arg)
+{
+   while (done < NUMRT)
+   {
+      work (1) ;
+      task_yield () ;
+   }
+   task_exit (0) ;
+}
+
+int main (int argc, char *argv[])
+{
+   long i ;
+
+   printf ("main: inicio\n");
+
+   ppos_init () ;
+
+   task_create (&hog, BodyHog, NULL) ;
+   for (i=0; i<NUMRT; i++)
+   {
+      task_create (&rt[i], BodyRT, (void *) i) ;
+      if (task_set_rt (&rt[i], period[i], budget[i], 0) < 0)
+         printf ("main: tarefa periodica %ld recusada\n", i) ;
+   }
+
+   // 75% ja admitidos: mais 50% passaria da capacidade
+   task_create (&extra, BodyExtra, NULL) ;
+   if (task_set_rt (&extra, 10, 5, 0) < 0)
+      printf ("main: tarefa periodica extra recusada\n") ;
+
+   for (i=0; i<NUMRT; i++)
+      task_join (&rt[i]) ;
+   task_join (&extra) ;
+   task_join (&hog) ;
+
+   printf ("main: fim\n");
+   exit (0);
+}
@@ -0,0 +1,107 @@
+// PingPongOS - PingPong Operating System
+
+// Teste dos futuros: resultados de tarefas aguardados com future_await_any,
+// um futuro concluido por outra tarefa (promessa) e varias transferencias
+// de disco em andamento ao mesmo tempo, disparadas por uma unica tarefa.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ppos.h"
+#include "ppos-disk-manager.h"
+
+#define NUMTASKS 3
+#define NUMBLOCKS 8
+
+task_t task[NUMTASKS], producer ;
+future_t result[NUMTASKS], promise ;
+
+// executa (arg) voltas e termina com codigo 10 * (arg)
+void Worker (void * arg)
+{
+   long n = (long) arg ;
+   int i ;
+
+   for (i = 0; i < n; i++)
+      task_yield () ;
+   task_exit (10 * n) ;
+}
+
+// conclui a promessa depois de algumas voltas
+void Producer (void * arg)
+{
+   int i ;
+
+   for (i = 0; i < 5; i++)
+      task_yield () ;
+   printf ("produtor: concluindo a promessa\n") ;
+   future_complete (&promise, 42) ;
+   task_exit (0) ;
+}
+
+int main (int argc, char *argv[])
+{
+   future_t *pending[NUMBLOCKS], io[NUMBLOCKS] ;
+   char out[NUMBLOCKS][64], in[NUMBLOCKS][64] ;
+   int i, k, n, numBlocks, blockSize, errors ;
+
+   printf ("main: inicio\n") ;
+
+   ppos_init () ;
+
+   // resultados de tarefas, na ordem em que terminam
+   for (i = 0; i < NUMTASKS; i++)
+   {
+      future_create (&result[i]) ;
+      task_create (&task[i], Worker, (void *) (long) (NUMTASKS - i)) ;
+      future_task (&result[i], &task[i]) ;
+      pending[i] = &result[i] ;
+   }
+   for (n = NUMTASKS; n > 0; n--)
+   {
+      k = future_await_any (pending, n) ;
+      printf ("main: tarefa %d terminou com %d\n", task[pending[k] - result].id,
+              pending[k]->result) ;
+      pending[k] = pending[n - 1] ;
+   }
+
+   // futuro de tarefa ja encerrada
+   future_create (&result[0]) ;
+   future_task (&result[0], &task[0]) ;
+   printf ("main: tarefa %d (encerrada) tem resultado %d\n", task[0].id,
+           future_await (&result[0])) ;
+
+   // promessa concluida por outra tarefa
+   future_create (&promise) ;
+   task_create (&producer, Producer, NULL) ;
+   printf ("main: promessa concluida com %d\n", future_await (&promise)) ;
+
+   // transferencias de disco concorrentes
+   if (disk_mgr_init (&numBlocks, &blockSize) < 0 || blockSize > 64)
+   {
+      printf ("main: erro ao iniciar o disco\n") ;
+      exit (1) ;
+   }
+   for (i = 0; i < NUMBLOCKS; i++)
+   {
+      memset (out[i], 'a' + i, blockSize) ;
+      future_create (&io[i]) ;
+      disk_block_write_async (i, out[i], &io[i]) ;
+      pending[i] = &io[i] ;
+   }
+   future_await_all (pending, NUMBLOCKS) ;
+   printf ("main: %d blocos escritos\n", NUMBLOCKS) ;
+
+   for (i = 0; i < NUMBLOCKS; i++)
+   {
+      future_create (&io[i]) ;
+      disk_block_read_async (i, in[i], &io[i]) ;
+   }
+   future_await_all (pending, NUMBLOCKS) ;
+   for (i = 0, errors = 0; i < NUMBLOCKS; i++)
+      errors += (memcmp (in[i], out[i], blockSize) != 0) ;
+   printf ("main: %d blocos lidos, %d diferentes do escrito\n", NUMBLOCKS, errors) ;
+
+   printf ("main: fim\n") ;
+   exit (0) ;
+}
@@ -0,0 +1,70 @@
+// PingPongOS - PingPong Operating System
+
+// Teste dos grupos de tarefas: main aguarda um grupo de tarefas com uma
+// unica chamada a group_join, que so retorna quando o ultimo membro
+// termina; o status e as ativacoes dos membros sao somados no grupo.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+
+#define NUMTASKS 5
+
+task_t task[NUMTASKS], other ;
+task_group_t group, empty ;
+int finished ;		// membros que ja terminaram
+
+// executa (arg) voltas; as tarefas pares terminam com erro
+void Body (void * arg)
+{
+   long n = (long) arg ;
+   int i ;
+
+   for (i = 0; i < n; i++)
+      task_yield () ;
+   finished++ ;
+   printf ("tarefa %d: fim apos %ld voltas\n", task_id (), n) ;
+   task_exit (n % 2 ? 0 : (int) n) ;
+}
+
+// tarefa fora do grupo, que nao e aguardada por group_join
+void Other (void * arg)
+{
+   int i ;
+
+   for (i = 0; i < 3 * NUMTASKS; i++)
+      task_yield () ;
+   printf ("tarefa %d: fim (fora do grupo)\n", task_id ()) ;
+   task_exit (0) ;
+}
+
+int main (int argc, char *argv[])
+{
+   int i, status ;
+
+   printf ("main: inicio\n") ;
+
+   ppos_init () ;
+
+   group_create (&group) ;
+   for (i = 0; i < NUMTASKS; i++)
+      group_task_create (&group, &task[i], Body, (void *) (long) (NUMTASKS - i)) ;
+   task_create (&other, Other, NULL) ;
+
+   status = group_join (&group) ;
+   printf ("main: grupo encerrado com status %d: %d/%d membros terminaram, %d com erro\n",
+           status, finished, group.members, group.failed) ;
+   printf ("main: %u ativacoes dos membros\n", group.activations) ;
+
+   // grupo sem membros nao bloqueia
+   group_create (&empty) ;
+   printf ("main: grupo vazio encerrado com status %d\n", group_join (&empty)) ;
+
+   group_destroy (&group) ;
+   group_destroy (&empty) ;
+   printf ("main: grupo destruido, join retorna %d\n", group_join (&group)) ;
+
+   task_join (&other) ;
+   printf ("main: fim\n") ;
+   exit (0) ;
+}
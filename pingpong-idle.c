@@ -0,0 +1,67 @@
+// PingPongOS - PingPong Operating System
+
+// Teste do dispatcher ocioso: varias tarefas leem blocos do disco e, na
+// maior parte do tempo, estao todas bloqueadas aguardando o sinal do disco.
+// No fim, main mostra o tempo decorrido, o tempo ocioso e o processador
+// consumido pelo processo. Por padrao o processo dorme enquanto ocioso e
+// consome muito menos processador que o tempo decorrido; com
+// PPOS_IDLE_SPIN=1 o dispatcher gira e os dois tempos ficam proximos.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+#include "ppos-disk-manager.h"
+
+#define NUMTASKS 4
+#define READS    4		// leituras de cada tarefa
+
+task_t reader[NUMTASKS] ;
+int numblocks ;			// numero de blocos no disco
+int blocksize ;			// tamanho de cada bloco (bytes)
+
+void BodyReader (void * arg)
+{
+   long n = (long) arg ;
+   char *buffer = malloc (blocksize) ;
+   int i, block ;
+
+   for (i = 0; i < READS; i++)
+   {
+      block = (n * READS + i) * numblocks / (NUMTASKS * READS) ;
+      if (disk_block_read (block, buffer) < 0)
+         printf ("T%02d erro ao ler bloco %3d\n", task_id (), block) ;
+   }
+   printf ("T%02d leu %d blocos\n", task_id (), READS) ;
+   free (buffer) ;
+   task_exit (0) ;
+}
+
+int main (int argc, char *argv[])
+{
+   unsigned int wall, idle, cpu ;
+   long i ;
+
+   printf ("main: inicio\n") ;
+
+   ppos_init () ;
+
+   if (disk_mgr_init (&numblocks, &blocksize) < 0)
+   {
+      printf ("Erro na abertura do disco\n") ;
+      exit (1) ;
+   }
+
+   for (i = 0; i < NUMTASKS; i++)
+      task_create (&reader[i], BodyReader, (void *) i) ;
+   for (i = 0; i < NUMTASKS; i++)
+      task_join (&reader[i]) ;
+
+   ppos_idle_stats (&wall, &idle, &cpu) ;
+   printf ("main: %u ms decorridos, %u ms ocioso (%.0f%%), %u ms de processador\n",
+           wall, idle, wall ? 100.0 * idle / wall : 0.0, cpu) ;
+
+   printf ("main: fim\n") ;
+   task_exit (0) ;
+
+   exit (0) ;
+}
@@ -0,0 +1,71 @@
+// PingPongOS - PingPong Operating System
+
+// Teste de muitas tarefas: cria 100 mil tarefas com pilhas pequenas, que
+// ficam bloqueadas em um semaforo ate serem liberadas pela main. As pilhas
+// sao so reservadas; cada tarefa ocupa na memoria real apenas as paginas
+// de pilha que chega a tocar.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+#include "ppos-stack.h"
+
+#define NUMTASKS 100000
+
+task_t *task, named ;
+semaphore_t s ;
+long sum = 0 ;
+
+// corpo das tarefas: espera a liberacao e soma seu argumento
+void Body (void * arg)
+{
+   sem_down (&s) ;
+   sum += (long) arg ;
+   task_exit (0) ;
+}
+
+int main (int argc, char *argv[])
+{
+   stackpool_stats_t stats ;
+   task_attr_t attr ;
+   long i ;
+
+   printf ("main: inicio\n") ;
+
+   // cada pilha com guarda ocupa dois mapeamentos e o Linux limita o
+   // numero deles por processo (vm.max_map_count)
+   setenv ("PPOS_STACK_GUARD", "0", 1) ;
+
+   ppos_init () ;
+
+   task = malloc (NUMTASKS * sizeof (task_t)) ;
+   sem_create (&s, 0) ;
+
+   task_attr_init (&attr) ;
+   attr.stackSize = PPOS_STACK_MIN ;
+   for (i = 0; i < NUMTASKS; i++)
+      task_create_attr (&task[i], Body, (void *) i, &attr) ;
+
+   attr.name = "nomeada" ;
+   attr.prio = -5 ;
+   task_create_attr (&named, Body, (void *) 0, &attr) ;
+   printf ("main: tarefa %d \"%s\", prioridade %d\n", named.id,
+           task_getname (&named), task_getprio (&named)) ;
+
+   // deixa todas as tarefas chegarem ao semaforo
+   task_yield () ;
+
+   stack_pool_stats (&stats) ;
+   printf ("main: %ld pilhas em uso\n", stats.inUse) ;
+
+   for (i = 0; i <= NUMTASKS; i++)
+      sem_up (&s) ;
+   for (i = 0; i < NUMTASKS; i++)
+      task_join (&task[i]) ;
+   task_join (&named) ;
+
+   printf ("main: soma %ld (esperado %ld)\n", sum,
+           (long) NUMTASKS * (NUMTASKS - 1) / 2) ;
+   printf ("main: fim\n") ;
+   exit (0) ;
+}
@@ -0,0 +1,53 @@
+// PingPongOS - PingPong Operating System
+
+// Teste do pool de pilhas: rodadas de tarefas que nascem e morrem devem
+// reaproveitar as pilhas das rodadas anteriores.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+#include "ppos-stack.h"
+
+#define ROUNDS   100
+#define NUMTASKS 10
+
+task_t task[NUMTASKS] ;
+
+// corpo das threads: usa um pouco de pilha e termina
+void Body (void * arg)
+{
+   char buffer[4096] ;
+   int i ;
+
+   for (i = 0; i < sizeof (buffer); i++)
+      buffer[i] = i ;
+   task_exit (buffer[(long) arg]) ;
+}
+
+int main (int argc, char *argv[])
+{
+   stackpool_stats_t stats ;
+   int i, r ;
+
+   printf ("main: inicio\n") ;
+
+   ppos_init () ;
+
+   for (r = 0; r < ROUNDS; r++)
+   {
+      for (i = 0; i < NUMTASKS; i++)
+         task_create (&task[i], Body, (void *) (long) i) ;
+      for (i = 0; i < NUMTASKS; i++)
+         task_join (&task[i]) ;
+
+      if (r == 0 || r == ROUNDS - 1)
+      {
+         stack_pool_stats (&stats) ;
+         printf ("rodada %3d: hits %ld, misses %ld, em uso %ld, no pool %ld\n",
+                 r, stats.hits, stats.misses, stats.inUse, stats.pooled) ;
+      }
+   }
+
+   printf ("main: fim\n") ;
+   exit (0) ;
+}
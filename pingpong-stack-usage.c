@@ -0,0 +1,45 @@
+// PingPongOS - PingPong Operating System
+
+// Teste da medicao de uso de pilha: tarefas que usam quantidades diferentes
+// de pilha; com PPOS_STACK_PAINT=1 o PPOS informa o pico de cada uma ao
+// termino e um histograma ao fim do processo. Os valores exatos dependem do
+// compilador, por isso nao ha saida esperada.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ppos.h"
+
+#define NUMTASKS 8
+
+task_t task[NUMTASKS] ;
+
+// usa cerca de (arg) KiB de pilha
+void Body (void * arg)
+{
+   long kib = (long) arg ;
+   char buffer[kib * 1024] ;
+
+   memset (buffer, 0, sizeof (buffer)) ;
+   task_exit (buffer[0]) ;
+}
+
+int main (int argc, char *argv[])
+{
+   int i ;
+
+   printf ("main: inicio\n") ;
+
+   setenv ("PPOS_STACK_PAINT", "1", 0) ;
+   ppos_init () ;
+
+   for (i = 0; i < NUMTASKS; i++)
+      task_create (&task[i], Body, (void *) (long) (i * 3)) ;
+
+   for (i = 0; i < NUMTASKS; i++)
+      task_join (&task[i]) ;
+
+   printf ("main: fim\n") ;
+   task_exit (0) ;
+   exit (0) ;
+}
@@ -0,0 +1,71 @@
+// PingPongOS - PingPong Operating System
+
+// Teste da divisao proporcional do processador (politica STRIDE): tres
+// tarefas com 300, 200 e 100 bilhetes executam o mesmo processamento em
+// trechos, cedendo o processador a cada trecho. Executar com
+// PPOS_CPU_SCHED=STRIDE e PPOS_SCHED_REPORT=1; no termino, cada tarefa
+// informa a parcela do processador obtida e a pedida pelos seus bilhetes.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+
+#define NUMTASKS 3
+#define CHUNKS   400		// trechos de processamento por tarefa
+#define WORKLOAD 300		// tamanho de cada trecho
+
+task_t task[NUMTASKS] ;
+int tickets[NUMTASKS] = { 300, 200, 100 } ;
+
+// simula um processamento pesado
+int hardwork (int n)
+{
+   int i, j ;
+   volatile int soma ;	// volatile: o laco nao pode ser eliminado com -O2
+
+   soma = 0 ;
+   for (i=0; i<n; i++)
+      for (j=0; j<n; j++)
+         soma += j ;
+   return (soma) ;
+}
+
+// corpo das threads
+void Body (void * arg)
+{
+   int i ;
+
+   printf ("tarefa %d: inicio (%d bilhetes)\n", task_id (),
+           task_get_tickets (NULL)) ;
+   for (i=0; i<CHUNKS; i++)
+   {
+      hardwork (WORKLOAD) ;
+      task_yield () ;
+   }
+   printf ("tarefa %d: fim\n", task_id ()) ;
+   task_exit (0) ;
+}
+
+int main (int argc, char *argv[])
+{
+   int i ;
+
+   printf ("main: inicio\n");
+
+   ppos_init () ;
+
+   printf ("main: politica %s\n", ppos_sched_name ()) ;
+
+   for (i=0; i<NUMTASKS; i++)
+   {
+      task_create (&task[i], Body, NULL) ;
+      task_set_tickets (&task[i], tickets[i]) ;
+   }
+
+   // main nao disputa o processador enquanto aguarda
+   for (i=0; i<NUMTASKS; i++)
+      task_join (&task[i]) ;
+
+   printf ("main: fim\n");
+   exit (0);
+}
@@ -0,0 +1,78 @@
+// PingPongOS - PingPong Operating System
+
+// Teste do relogio de alta resolucao: tarefas leem systime_ns() em laco,
+// cedendo o processador entre as leituras, e conferem que o relogio nunca
+// volta e concorda com systime() e systime_us(). No fim, main mede o custo
+// de uma leitura de systime_ns() e o de clock_gettime feito por chamada de
+// sistema, sem o vDSO.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "ppos.h"
+
+#define NUMTASKS 4
+#define ROUNDS   1000		// leituras de cada tarefa
+#define CALLS    1000000	// leituras na medida do custo
+
+task_t task[NUMTASKS] ;
+unsigned long long last ;	// ultima leitura de qualquer tarefa
+int errors ;
+
+void Body (void * arg)
+{
+   unsigned long long ns, us ;
+   unsigned int ms ;
+   int i ;
+
+   for (i = 0; i < ROUNDS; i++)
+   {
+      ms = systime () ;
+      ns = systime_ns () ;
+      us = systime_us () ;
+      if (ns < last || us < ns / 1000 || ns / 1000000 + 1 < ms)
+      {
+         printf ("T%d: leitura incoerente (%llu ns, %llu us, %u ms)\n",
+                 task_id (), ns, us, ms) ;
+         errors++ ;
+      }
+      last = ns ;
+      task_yield () ;
+   }
+   printf ("T%d: fim\n", task_id ()) ;
+   task_exit (0) ;
+}
+
+int main (int argc, char *argv[])
+{
+   unsigned long long start, vdso, sys ;
+   struct timespec ts ;
+   long i ;
+
+   printf ("main: inicio\n") ;
+
+   ppos_init () ;
+
+   for (i = 0; i < NUMTASKS; i++)
+      task_create (&task[i], Body, NULL) ;
+   for (i = 0; i < NUMTASKS; i++)
+      task_join (&task[i]) ;
+   printf ("main: %d leituras incoerentes\n", errors) ;
+
+   start = systime_ns () ;
+   for (i = 0; i < CALLS; i++)
+      systime_ns () ;
+   vdso = systime_ns () - start ;
+
+   start = systime_ns () ;
+   for (i = 0; i < CALLS; i++)
+      syscall (SYS_clock_gettime, CLOCK_MONOTONIC, &ts) ;
+   sys = systime_ns () - start ;
+
+   printf ("main: systime_ns %.1f ns por leitura, chamada de sistema %.1f ns\n",
+           (double) vdso / CALLS, (double) sys / CALLS) ;
+   printf ("main: fim\n") ;
+   exit (0) ;
+}
@@ -0,0 +1,215 @@
+// PingPongOS - PingPong Operating System
+
+// Teste das esperas com prazo: cada operacao e testada com um prazo que
+// vence (e deve durar o prazo) e com um que nao vence (a espera termina
+// quando outra tarefa libera o objeto). As pausas em ms usam a propria
+// sem_down_timed, pois task_sleep conta segundos. No fim, varias tarefas
+// disputam um semaforo com prazos variados enquanto outra o libera: cada
+// liberacao deve ser obtida por exatamente uma tarefa ou ficar no semaforo,
+// sem despertares espurios.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+
+#define NUMWAITERS 50
+#define NUMUPS     200
+#define ROUNDS     20		// esperas de cada tarefa na disputa
+
+task_t helper, helper2, waiter[NUMWAITERS], giver ;
+semaphore_t s, race ;
+mutex_t m ;
+barrier_t bar ;
+mqueue_t mq ;
+int got[NUMWAITERS], timeouts ;
+
+// suspende a tarefa corrente por t ms
+void pause_ms (int t)
+{
+   semaphore_t never ;
+
+   sem_create (&never, 0) ;
+   sem_down_timed (&never, t) ;
+   sem_destroy (&never) ;
+}
+
+// confere o resultado e a duracao de uma espera
+void check (char *op, int result, int expected, unsigned int start,
+            unsigned int min, unsigned int max)
+{
+   unsigned int t = systime () - start ;
+
+   printf ("%s: %s, %s\n", op,
+           result == expected ? "resultado correto" : "resultado ERRADO",
+           (t >= min && t <= max) ? "duracao correta" : "duracao ERRADA") ;
+   if (result != expected || t < min || t > max)
+      printf ("  (retornou %d em %u ms, esperado %d em %u a %u ms)\n",
+              result, t, expected, min, max) ;
+}
+
+void BodySem (void * arg)
+{
+   pause_ms (50) ;
+   sem_up (&s) ;
+   task_exit (0) ;
+}
+
+void BodyMutex (void * arg)
+{
+   mutex_lock (&m) ;
+   pause_ms (50) ;
+   mutex_unlock (&m) ;
+   task_exit (0) ;
+}
+
+void BodyBarrier (void * arg)
+{
+   pause_ms (50) ;
+   barrier_join (&bar) ;
+   task_exit (0) ;
+}
+
+void BodySend (void * arg)
+{
+   int msg = 42 ;
+
+   pause_ms (50) ;
+   mqueue_send (&mq, &msg) ;
+   task_exit (0) ;
+}
+
+void BodyExit (void * arg)
+{
+   pause_ms (300) ;
+   task_exit (7) ;
+}
+
+void BodyWaiter (void * arg)
+{
+   long n = (long) arg ;
+   int i ;
+
+   for (i = 0; i < ROUNDS; i++)
+   {
+      if (sem_down_timed (&race, 1 + (n + i) % 7) == 0)
+         got[n]++ ;
+      else
+         timeouts++ ;
+   }
+   task_exit (0) ;
+}
+
+void BodyGiver (void * arg)
+{
+   int i ;
+
+   for (i = 0; i < NUMUPS; i++)
+   {
+      sem_up (&race) ;
+      if (i % 10 == 0)
+         pause_ms (1) ;
+   }
+   task_exit (0) ;
+}
+
+int main (int argc, char *argv[])
+{
+   unsigned int start ;
+   int i, msg, total ;
+
+   printf ("main: inicio\n") ;
+
+   ppos_init () ;
+
+   // semaforo
+   sem_create (&s, 0) ;
+   start = systime () ;
+   check ("sem_down_timed, vence", sem_down_timed (&s, 100), PPOS_TIMEOUT,
+          start, 100, 150) ;
+   start = systime () ;
+   check ("sem_down_timed, prazo zero", sem_down_timed (&s, 0), PPOS_TIMEOUT,
+          start, 0, 10) ;
+   task_create (&helper, BodySem, NULL) ;
+   start = systime () ;
+   check ("sem_down_timed, liberado", sem_down_timed (&s, 1000), 0,
+          start, 50, 80) ;
+   printf ("semaforo com valor %d\n", s.value) ;
+   task_join (&helper) ;
+
+   // mutex: a tarefa auxiliar o obtem e o libera 50 ms depois
+   mutex_create (&m) ;
+   task_create (&helper, BodyMutex, NULL) ;
+   task_yield () ;
+   start = systime () ;
+   check ("mutex_lock_timed, prazo zero", mutex_lock_timed (&m, 0),
+          PPOS_TIMEOUT, start, 0, 10) ;
+   check ("mutex_lock_timed, vence", mutex_lock_timed (&m, 20), PPOS_TIMEOUT,
+          start, 20, 35) ;
+   check ("mutex_lock_timed, liberado", mutex_lock_timed (&m, 1000), 0,
+          start, 50, 80) ;
+   mutex_unlock (&m) ;
+   task_join (&helper) ;
+
+   // barreira de tres tarefas: quem desiste deixa de contar como chegada
+   barrier_create (&bar, 3) ;
+   start = systime () ;
+   check ("barrier_join_timed, vence", barrier_join_timed (&bar, 30),
+          PPOS_TIMEOUT, start, 30, 45) ;
+   task_create (&helper, BodyBarrier, NULL) ;
+   task_create (&helper2, BodyBarrier, NULL) ;
+   start = systime () ;
+   check ("barrier_join_timed, completa", barrier_join_timed (&bar, 1000), 0,
+          start, 50, 80) ;
+   task_join (&helper) ;
+   task_join (&helper2) ;
+
+   // fila de mensagens com duas vagas
+   mqueue_create (&mq, 2, sizeof (int)) ;
+   start = systime () ;
+   check ("mqueue_recv_timed, vence", mqueue_recv_timed (&mq, &msg, 30),
+          PPOS_TIMEOUT, start, 30, 45) ;
+   task_create (&helper, BodySend, NULL) ;
+   start = systime () ;
+   msg = 0 ;
+   check ("mqueue_recv_timed, recebe", mqueue_recv_timed (&mq, &msg, 1000), 0,
+          start, 50, 80) ;
+   printf ("mensagem recebida: %d\n", msg) ;
+   task_join (&helper) ;
+   check ("mqueue_send_timed, vaga", mqueue_send_timed (&mq, &msg, 0), 0,
+          start, 0, 1000) ;
+   check ("mqueue_send_timed, vaga", mqueue_send_timed (&mq, &msg, 0), 0,
+          start, 0, 1000) ;
+   start = systime () ;
+   check ("mqueue_send_timed, vence", mqueue_send_timed (&mq, &msg, 20),
+          PPOS_TIMEOUT, start, 20, 35) ;
+   printf ("fila com %d mensagens\n", mqueue_msgs (&mq)) ;
+
+   // espera pelo fim de uma tarefa que encerra aos 300 ms
+   task_create (&helper, BodyExit, NULL) ;
+   start = systime () ;
+   check ("task_join_timed, vence", task_join_timed (&helper, 100),
+          PPOS_TIMEOUT, start, 100, 150) ;
+   check ("task_join_timed, encerrada", task_join_timed (&helper, 1000), 7,
+          start, 300, 350) ;
+   check ("task_join_timed, ja encerrada", task_join_timed (&helper, 0), 7,
+          start, 300, 350) ;
+
+   // disputa: cada liberacao e obtida uma vez ou fica no semaforo
+   sem_create (&race, 0) ;
+   for (i = 0; i < NUMWAITERS; i++)
+      task_create (&waiter[i], BodyWaiter, (void *) (long) i) ;
+   task_create (&giver, BodyGiver, NULL) ;
+   for (i = 0; i < NUMWAITERS; i++)
+      task_join (&waiter[i]) ;
+   task_join (&giver) ;
+   for (total = i = 0; i < NUMWAITERS; i++)
+      total += got[i] ;
+   if (total + race.value == NUMUPS && total + timeouts == NUMWAITERS * ROUNDS)
+      printf ("disputa: liberacoes e esperas conferem\n") ;
+   else
+      printf ("disputa: contagem ERRADA (%d obtidas, %d no semaforo, "
+              "%d prazos vencidos)\n", total, race.value, timeouts) ;
+
+   printf ("main: fim\n") ;
+   exit (0) ;
+}
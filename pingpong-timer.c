@@ -0,0 +1,103 @@
+// PingPongOS - PingPong Operating System
+
+// Teste dos temporizadores de software: mil temporizadores periodicos (de
+// 10 a 19 ms) contam as suas expiracoes enquanto uma tarefa processa sem
+// ceder o processador por 1 s, entao as chamadas dependem do tick. Um
+// temporizador de disparo unico deve expirar uma vez, um cancelado antes do
+// prazo nunca, e um periodico que se cancela na quinta expiracao deve
+// expirar exatamente cinco vezes. No fim, main confere as contagens.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+
+#define NUMTIMERS 1000
+#define WORK      1000		// processamento da tarefa (ms)
+
+swtimer_t timer[NUMTIMERS], once, never, selfstop ;
+int count[NUMTIMERS] ;
+int onceCount, neverCount, selfCount ;
+task_t hog ;
+
+void Tick (void * arg)
+{
+   count[(long) arg]++ ;
+}
+
+void Once (void * arg)
+{
+   onceCount++ ;
+}
+
+void Never (void * arg)
+{
+   neverCount++ ;
+}
+
+void SelfStop (void * arg)
+{
+   if (++selfCount == 5)
+      timer_cancel (&selfstop) ;
+}
+
+// processa sem ceder o processador
+void BodyHog (void * arg)
+{
+   unsigned long long end = systime_ns () + WORK * 1000000ULL ;
+
+   while (systime_ns () < end) ;
+   task_exit (0) ;
+}
+
+int main (int argc, char *argv[])
+{
+   unsigned int start, elapsed, expected, got ;
+   int i, errors = 0 ;
+
+   printf ("main: inicio\n") ;
+
+   ppos_init () ;
+
+   start = systime () ;
+   for (i = 0; i < NUMTIMERS; i++)
+   {
+      timer_init (&timer[i], Tick, (void *) (long) i) ;
+      timer_start (&timer[i], 10 + i % 10, 10 + i % 10) ;
+   }
+   timer_init (&once, Once, NULL) ;
+   timer_start (&once, 50, 0) ;
+   timer_init (&never, Never, NULL) ;
+   timer_start (&never, 100, 0) ;
+   timer_init (&selfstop, SelfStop, NULL) ;
+   timer_start (&selfstop, 20, 20) ;
+
+   if (timer_cancel (&never) < 0 || timer_pending (&never))
+      printf ("main: erro ao cancelar o temporizador\n") ;
+
+   task_create (&hog, BodyHog, NULL) ;
+   task_join (&hog) ;
+
+   // cancela os periodicos e confere as expiracoes: as tratadas mais as
+   // perdidas por atraso devem cobrir o tempo decorrido
+   for (i = 0; i < NUMTIMERS; i++)
+      timer_cancel (&timer[i]) ;
+   elapsed = systime () - start ;
+   for (i = 0; i < NUMTIMERS; i++)
+   {
+      expected = elapsed / (10 + i % 10) ;
+      got = count[i] + timer[i].overruns ;
+      if (got + 1 < expected || got > expected)
+      {
+         printf ("main: temporizador %d expirou %u vezes, esperado %u\n",
+                 i, got, expected) ;
+         errors++ ;
+      }
+   }
+   printf ("main: %d temporizadores periodicos fora do esperado\n", errors) ;
+   printf ("main: disparo unico: %d expiracao(oes)\n", onceCount) ;
+   printf ("main: cancelado: %d expiracao(oes)\n", neverCount) ;
+   printf ("main: cancelado na quinta: %d expiracao(oes), %s\n", selfCount,
+           timer_pending (&selfstop) ? "armado" : "desarmado") ;
+   printf ("main: fim\n") ;
+   exit (0) ;
+}
@@ -0,0 +1,111 @@
+// PingPongOS - PingPong Operating System
+
+// Teste do armazenamento local de tarefa: cada tarefa guarda um buffer de
+// log proprio sob a mesma chave; o destrutor da chave libera o buffer
+// quando a tarefa termina. Uma chave apagada e recriada no mesmo indice
+// nao deve ver os valores da chave antiga, nem entrega-los ao novo
+// destrutor.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ppos.h"
+
+#define NUMTASKS 3
+
+task_t task[NUMTASKS], keeper ;
+int logKey, countKey, oldKey ;
+int recreated ;		// oldKey ja foi apagada e recriada
+
+// destrutor da chave de log: imprime e libera o buffer da tarefa
+void log_destroy (void *value)
+{
+   printf ("tarefa %d: log \"%s\" liberado\n", task_id (), (char *) value) ;
+   free (value) ;
+}
+
+// acrescenta texto ao log da tarefa corrente
+void log_append (char *text)
+{
+   char *buf = task_getspecific (logKey) ;
+
+   if (!buf)
+   {
+      buf = calloc (1, 64) ;
+      task_setspecific (logKey, buf) ;
+   }
+   strncat (buf, text, 63 - strlen (buf)) ;
+}
+
+void Body (void * arg)
+{
+   long n = (long) arg ;
+   int i ;
+
+   for (i = 0; i <= n; i++)
+   {
+      log_append (i ? "+" : "ini") ;
+      // o contador nao tem destrutor: guarda o valor no proprio ponteiro
+      task_setspecific (countKey, (void *) (long) (i + 1)) ;
+      task_yield () ;
+   }
+   printf ("tarefa %d: log \"%s\", contador %ld\n", task_id (),
+           (char *) task_getspecific (logKey), (long) task_getspecific (countKey)) ;
+   task_exit (0) ;
+}
+
+// guarda um valor sob oldKey e o procura depois que a chave e recriada
+void Keeper (void * arg)
+{
+   task_setspecific (oldKey, "antigo") ;
+   while (!recreated)
+      task_yield () ;
+   printf ("tarefa %d: valor da chave recriada %s\n", task_id (),
+           task_getspecific (oldKey) ? "ANTIGO" : "nulo") ;
+   task_exit (0) ;
+}
+
+int main (int argc, char *argv[])
+{
+   int i, key, old ;
+
+   printf ("main: inicio\n") ;
+
+   ppos_init () ;
+
+   task_key_create (&logKey, log_destroy) ;
+   task_key_create (&countKey, NULL) ;
+
+   for (i = 0; i < NUMTASKS; i++)
+      task_create (&task[i], Body, (void *) (long) i) ;
+
+   log_append ("main") ;
+
+   for (i = 0; i < NUMTASKS; i++)
+      task_join (&task[i]) ;
+
+   printf ("main: contador %ld\n", (long) task_getspecific (countKey)) ;
+
+   // apaga e recria uma chave com valor em uma tarefa viva
+   task_key_create (&oldKey, NULL) ;
+   task_create (&keeper, Keeper, NULL) ;
+   task_yield () ;
+   old = oldKey ;
+   task_key_delete (oldKey) ;
+   printf ("main: chave apagada: set %d, get %s\n",
+           task_setspecific (oldKey, "novo"),
+           task_getspecific (oldKey) ? "valor" : "nulo") ;
+   task_key_create (&oldKey, log_destroy) ;
+   printf ("main: chave recriada no %s indice\n", oldKey == old ? "mesmo" : "outro") ;
+   recreated = 1 ;
+   task_join (&keeper) ;
+
+   // esgota as chaves restantes
+   for (i = 0; task_key_create (&key, NULL) == 0; i++) ;
+   printf ("main: %d chaves livres restantes\n", i) ;
+
+   // main termina com exit: o destrutor nao e chamado para o seu valor
+   printf ("main: log \"%s\"\n", (char *) task_getspecific (logKey)) ;
+   printf ("main: fim\n") ;
+   exit (0) ;
+}
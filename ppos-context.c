@@ -0,0 +1,361 @@
+// PingPongOS - PingPong Operating System
+
+// Backend opcional de troca de contexto escrito em assembly.
+//
+// O nucleo (ppos-all.o) cria e troca contextos com getcontext, makecontext
+// e swapcontext. As versoes da glibc salvam e restauram a mascara de sinais
+// em toda troca, o que custa uma chamada de sistema (rt_sigprocmask) por
+// task_switch. Compilando este arquivo com -DPPOS_ASM_CONTEXT, as funcoes
+// abaixo substituem as da glibc na ligacao: salvam somente os registradores
+// preservados pela ABI (callee-saved), o ponteiro de pilha e o endereco de
+// retorno, sem chamadas de sistema.
+//
+// Restricoes do backend assembly:
+// - a mascara de sinais NAO faz parte do contexto: um tratador de sinal que
+//   troca de tarefa deve ser instalado com SA_NODEFER;
+// - o layout dos registradores dentro do ucontext_t e proprio deste arquivo,
+//   entao um contexto so pode ser retomado pelas funcoes daqui;
+// - arquiteturas suportadas: x86-64 e aarch64.
+
+#define _GNU_SOURCE
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include "ppos-context.h"
+
+#ifndef PPOS_ASM_CONTEXT
+
+const char *context_backend ()
+{
+   return "ucontext" ;
+}
+
+// o makecontext da glibc poe a funcao no PC e o argumento no primeiro
+// registrador de parametro
+int context_entry (ucontext_t *ctx, void (**func)(void *), void **arg)
+{
+#if defined(__x86_64__)
+   *func = (void (*)(void *)) ctx->uc_mcontext.gregs[REG_RIP] ;
+   *arg = (void *) ctx->uc_mcontext.gregs[REG_RDI] ;
+   return (0) ;
+#elif defined(__aarch64__)
+   *func = (void (*)(void *)) ctx->uc_mcontext.pc ;
+   *arg = (void *) ctx->uc_mcontext.regs[0] ;
+   return (0) ;
+#else
+   return (-1) ;
+#endif
+}
+
+#else
+
+const char *context_backend ()
+{
+   return "asm" ;
+}
+
+#define STR_(x) #x
+#define STR(x)  STR_(x)
+
+// deslocamentos dos campos do ucontext_t usados pelo codigo assembly;
+// conferidos em tempo de compilacao pelos _Static_assert abaixo
+#define CTX_LINK 8
+
+#if defined(__x86_64__)
+
+#define CTX_R8    40
+#define CTX_R9    48
+#define CTX_R12   72
+#define CTX_R13   80
+#define CTX_R14   88
+#define CTX_R15   96
+#define CTX_RDI  104
+#define CTX_RSI  112
+#define CTX_RBP  120
+#define CTX_RBX  128
+#define CTX_RDX  136
+#define CTX_RCX  152
+#define CTX_RSP  160
+#define CTX_RIP  168
+#define CTX_CWD  424
+#define CTX_MXCSR 448
+
+#define CHECK_GREG(reg) \
+   _Static_assert (offsetof (ucontext_t, uc_mcontext.gregs[REG_##reg]) == CTX_##reg, \
+                   "deslocamento de " #reg " no ucontext_t")
+
+_Static_assert (offsetof (ucontext_t, uc_link) == CTX_LINK, "deslocamento de uc_link") ;
+CHECK_GREG (R8) ;  CHECK_GREG (R9) ;  CHECK_GREG (R12) ; CHECK_GREG (R13) ;
+CHECK_GREG (R14) ; CHECK_GREG (R15) ; CHECK_GREG (RDI) ; CHECK_GREG (RSI) ;
+CHECK_GREG (RBP) ; CHECK_GREG (RBX) ; CHECK_GREG (RDX) ; CHECK_GREG (RCX) ;
+CHECK_GREG (RSP) ; CHECK_GREG (RIP) ;
+_Static_assert (offsetof (ucontext_t, __fpregs_mem.cwd) == CTX_CWD, "deslocamento de cwd") ;
+_Static_assert (offsetof (ucontext_t, __fpregs_mem.mxcsr) == CTX_MXCSR, "deslocamento de mxcsr") ;
+
+// salva o contexto corrente em (%rdi); retorna para o chamador de quem
+// invocou a funcao (o endereco de retorno esta no topo da pilha)
+#define SAVE_CONTEXT \
+   "movq %rbx, " STR(CTX_RBX) "(%rdi)\n"  \
+   "movq %rbp, " STR(CTX_RBP) "(%rdi)\n"  \
+   "movq %r12, " STR(CTX_R12) "(%rdi)\n"  \
+   "movq %r13, " STR(CTX_R13) "(%rdi)\n"  \
+   "movq %r14, " STR(CTX_R14) "(%rdi)\n"  \
+   "movq %r15, " STR(CTX_R15) "(%rdi)\n"  \
+   "leaq 8(%rsp), %rcx\n"                 \
+   "movq %rcx, " STR(CTX_RSP) "(%rdi)\n"  \
+   "movq (%rsp), %rcx\n"                  \
+   "movq %rcx, " STR(CTX_RIP) "(%rdi)\n"  \
+   "fnstcw " STR(CTX_CWD) "(%rdi)\n"      \
+   "stmxcsr " STR(CTX_MXCSR) "(%rdi)\n"
+
+// retoma o contexto apontado por %rsi
+#define RESTORE_CONTEXT \
+   "fldcw " STR(CTX_CWD) "(%rsi)\n"       \
+   "ldmxcsr " STR(CTX_MXCSR) "(%rsi)\n"   \
+   "movq " STR(CTX_RBX) "(%rsi), %rbx\n"  \
+   "movq " STR(CTX_RBP) "(%rsi), %rbp\n"  \
+   "movq " STR(CTX_R12) "(%rsi), %r12\n"  \
+   "movq " STR(CTX_R13) "(%rsi), %r13\n"  \
+   "movq " STR(CTX_R14) "(%rsi), %r14\n"  \
+   "movq " STR(CTX_R15) "(%rsi), %r15\n"  \
+   "movq " STR(CTX_RSP) "(%rsi), %rsp\n"  \
+   "xorl %eax, %eax\n"                    \
+   "jmpq *" STR(CTX_RIP) "(%rsi)\n"
+
+__asm__ (
+   ".text\n"
+
+   ".globl getcontext\n"
+   ".type getcontext, @function\n"
+   "getcontext:\n"
+   SAVE_CONTEXT
+   "xorl %eax, %eax\n"
+   "ret\n"
+   ".size getcontext, .-getcontext\n"
+
+   ".globl setcontext\n"
+   ".type setcontext, @function\n"
+   "setcontext:\n"
+   "movq %rdi, %rsi\n"
+   RESTORE_CONTEXT
+   ".size setcontext, .-setcontext\n"
+
+   ".globl swapcontext\n"
+   ".type swapcontext, @function\n"
+   "swapcontext:\n"
+   SAVE_CONTEXT
+   RESTORE_CONTEXT
+   ".size swapcontext, .-swapcontext\n"
+
+   // ponto de entrada de um contexto novo: %rbx aponta o ucontext_t,
+   // %r12 a funcao e os argumentos estao nos slots dos registradores
+   ".type ppos_context_start, @function\n"
+   "ppos_context_start:\n"
+   ".cfi_startproc\n"
+   ".cfi_undefined rip\n"
+   "movq " STR(CTX_RDI) "(%rbx), %rdi\n"
+   "movq " STR(CTX_RSI) "(%rbx), %rsi\n"
+   "movq " STR(CTX_RDX) "(%rbx), %rdx\n"
+   "movq " STR(CTX_RCX) "(%rbx), %rcx\n"
+   "movq " STR(CTX_R8) "(%rbx), %r8\n"
+   "movq " STR(CTX_R9) "(%rbx), %r9\n"
+   "callq *%r12\n"
+   "movq " STR(CTX_LINK) "(%rbx), %rdi\n"
+   "testq %rdi, %rdi\n"
+   "jz 1f\n"
+   "call setcontext\n"
+   "1:\n"
+   "xorl %edi, %edi\n"
+   "call exit@PLT\n"
+   "hlt\n"
+   ".cfi_endproc\n"
+   ".size ppos_context_start, .-ppos_context_start\n"
+) ;
+
+void ppos_context_start () ;
+
+void makecontext (ucontext_t *ucp, void (*func) (void), int argc, ...)
+{
+   static const int argreg[] = { REG_RDI, REG_RSI, REG_RDX, REG_RCX, REG_R8, REG_R9 } ;
+   greg_t *gregs = ucp->uc_mcontext.gregs ;
+   uintptr_t sp ;
+   va_list ap ;
+   int i ;
+
+   va_start (ap, argc) ;
+   for (i = 0; i < argc && i < 6; i++)
+      gregs[argreg[i]] = va_arg (ap, greg_t) ;
+   va_end (ap) ;
+
+   // pilha alinhada em 16 bytes, como exige a ABI no ponto de chamada
+   sp = ((uintptr_t) ucp->uc_stack.ss_sp + ucp->uc_stack.ss_size) & ~(uintptr_t) 15 ;
+
+   gregs[REG_RBX] = (greg_t) ucp ;
+   gregs[REG_R12] = (greg_t) func ;
+   gregs[REG_RBP] = 0 ;
+   gregs[REG_RSP] = (greg_t) sp ;
+   gregs[REG_RIP] = (greg_t) ppos_context_start ;
+
+   // o contexto novo herda o modo de ponto flutuante do criador
+   __asm__ ("fnstcw %0" : "=m" (ucp->__fpregs_mem.cwd)) ;
+   __asm__ ("stmxcsr %0" : "=m" (ucp->__fpregs_mem.mxcsr)) ;
+}
+
+int context_entry (ucontext_t *ctx, void (**func)(void *), void **arg)
+{
+   *func = (void (*)(void *)) ctx->uc_mcontext.gregs[REG_R12] ;
+   *arg = (void *) ctx->uc_mcontext.gregs[REG_RDI] ;
+   return (0) ;
+}
+
+#elif defined(__aarch64__)
+
+#define CTX_X0   184
+#define CTX_X19  336
+#define CTX_X29  416
+#define CTX_SP   432
+#define CTX_PC   440
+#define CTX_FPR  464
+
+_Static_assert (offsetof (ucontext_t, uc_link) == CTX_LINK, "deslocamento de uc_link") ;
+_Static_assert (offsetof (ucontext_t, uc_mcontext.regs[0]) == CTX_X0, "deslocamento de x0") ;
+_Static_assert (offsetof (ucontext_t, uc_mcontext.regs[19]) == CTX_X19, "deslocamento de x19") ;
+_Static_assert (offsetof (ucontext_t, uc_mcontext.regs[29]) == CTX_X29, "deslocamento de x29") ;
+_Static_assert (offsetof (ucontext_t, uc_mcontext.sp) == CTX_SP, "deslocamento de sp") ;
+_Static_assert (offsetof (ucontext_t, uc_mcontext.pc) == CTX_PC, "deslocamento de pc") ;
+_Static_assert (offsetof (ucontext_t, uc_mcontext.__reserved) == CTX_FPR, "deslocamento de __reserved") ;
+
+// salva o contexto corrente em [x0]; d8-d15 vao para a area __reserved
+#define SAVE_CONTEXT \
+   "stp x19, x20, [x0, #" STR(CTX_X19) "]\n"       \
+   "stp x21, x22, [x0, #(" STR(CTX_X19) " + 16)]\n"  \
+   "stp x23, x24, [x0, #(" STR(CTX_X19) " + 32)]\n"  \
+   "stp x25, x26, [x0, #(" STR(CTX_X19) " + 48)]\n"  \
+   "stp x27, x28, [x0, #(" STR(CTX_X19) " + 64)]\n"  \
+   "stp x29, x30, [x0, #" STR(CTX_X29) "]\n"       \
+   "mov x9, sp\n"                                  \
+   "str x9, [x0, #" STR(CTX_SP) "]\n"              \
+   "str x30, [x0, #" STR(CTX_PC) "]\n"             \
+   "add x9, x0, #" STR(CTX_FPR) "\n"               \
+   "stp d8, d9, [x9]\n"                            \
+   "stp d10, d11, [x9, #16]\n"                     \
+   "stp d12, d13, [x9, #32]\n"                     \
+   "stp d14, d15, [x9, #48]\n"
+
+// retoma o contexto apontado por x1
+#define RESTORE_CONTEXT \
+   "add x9, x1, #" STR(CTX_FPR) "\n"               \
+   "ldp d8, d9, [x9]\n"                            \
+   "ldp d10, d11, [x9, #16]\n"                     \
+   "ldp d12, d13, [x9, #32]\n"                     \
+   "ldp d14, d15, [x9, #48]\n"                     \
+   "ldp x19, x20, [x1, #" STR(CTX_X19) "]\n"       \
+   "ldp x21, x22, [x1, #(" STR(CTX_X19) " + 16)]\n"  \
+   "ldp x23, x24, [x1, #(" STR(CTX_X19) " + 32)]\n"  \
+   "ldp x25, x26, [x1, #(" STR(CTX_X19) " + 48)]\n"  \
+   "ldp x27, x28, [x1, #(" STR(CTX_X19) " + 64)]\n"  \
+   "ldp x29, x30, [x1, #" STR(CTX_X29) "]\n"       \
+   "ldr x9, [x1, #" STR(CTX_SP) "]\n"              \
+   "mov sp, x9\n"                                  \
+   "ldr x16, [x1, #" STR(CTX_PC) "]\n"             \
+   "mov x0, #0\n"                                  \
+   "br x16\n"
+
+__asm__ (
+   ".text\n"
+
+   ".globl getcontext\n"
+   ".type getcontext, %function\n"
+   "getcontext:\n"
+   SAVE_CONTEXT
+   "mov x0, #0\n"
+   "ret\n"
+   ".size getcontext, .-getcontext\n"
+
+   ".globl setcontext\n"
+   ".type setcontext, %function\n"
+   "setcontext:\n"
+   "mov x1, x0\n"
+   RESTORE_CONTEXT
+   ".size setcontext, .-setcontext\n"
+
+   ".globl swapcontext\n"
+   ".type swapcontext, %function\n"
+   "swapcontext:\n"
+   SAVE_CONTEXT
+   RESTORE_CONTEXT
+   ".size swapcontext, .-swapcontext\n"
+
+   // ponto de entrada de um contexto novo: x19 aponta o ucontext_t,
+   // x20 a funcao e os argumentos estao nos slots de x0-x7
+   ".type ppos_context_start, %function\n"
+   "ppos_context_start:\n"
+   ".cfi_startproc\n"
+   ".cfi_undefined x30\n"
+   "ldp x0, x1, [x19, #" STR(CTX_X0) "]\n"
+   "ldp x2, x3, [x19, #(" STR(CTX_X0) " + 16)]\n"
+   "ldp x4, x5, [x19, #(" STR(CTX_X0) " + 32)]\n"
+   "ldp x6, x7, [x19, #(" STR(CTX_X0) " + 48)]\n"
+   "blr x20\n"
+   "ldr x0, [x19, #" STR(CTX_LINK) "]\n"
+   "cbz x0, 1f\n"
+   "bl setcontext\n"
+   "1:\n"
+   "mov x0, #0\n"
+   "bl exit\n"
+   "brk #0\n"
+   ".cfi_endproc\n"
+   ".size ppos_context_start, .-ppos_context_start\n"
+) ;
+
+void ppos_context_start () ;
+
+void makecontext (ucontext_t *ucp, void (*func) (void), int argc, ...)
+{
+   unsigned long long *regs = ucp->uc_mcontext.regs ;
+   uintptr_t sp ;
+   va_list ap ;
+   int i ;
+
+   va_start (ap, argc) ;
+   for (i = 0; i < argc && i < 8; i++)
+      regs[i] = va_arg (ap, unsigned long long) ;
+   va_end (ap) ;
+
+   sp = ((uintptr_t) ucp->uc_stack.ss_sp + ucp->uc_stack.ss_size) & ~(uintptr_t) 15 ;
+
+   regs[19] = (uintptr_t) ucp ;
+   regs[20] = (uintptr_t) func ;
+   regs[29] = 0 ;
+   regs[30] = 0 ;
+   ucp->uc_mcontext.sp = sp ;
+   ucp->uc_mcontext.pc = (uintptr_t) ppos_context_start ;
+}
+
+int context_entry (ucontext_t *ctx, void (**func)(void *), void **arg)
+{
+   *func = (void (*)(void *)) ctx->uc_mcontext.regs[20] ;
+   *arg = (void *) ctx->uc_mcontext.regs[0] ;
+   return (0) ;
+}
+
+#else
+#error "PPOS_ASM_CONTEXT: arquitetura nao suportada (use x86-64 ou aarch64)"
+#endif
+
+#endif
+
+// o contexto entregue a um tratador SA_SIGINFO vem do kernel, com o mesmo
+// layout em ambos os backends
+void *context_pc (void *uc)
+{
+#if defined(__x86_64__)
+   return ((void *) ((ucontext_t *) uc)->uc_mcontext.gregs[REG_RIP]) ;
+#elif defined(__aarch64__)
+   return ((void *) ((ucontext_t *) uc)->uc_mcontext.pc) ;
+#else
+   return (NULL) ;
+#endif
+}
@@ -0,0 +1,23 @@
+// PingPongOS - PingPong Operating System
+
+// Backend de troca de contexto usado pelo nucleo (ver ppos-context.c)
+
+#ifndef __PPOS_CONTEXT__
+#define __PPOS_CONTEXT__
+
+#include <ucontext.h>
+
+// nome do backend em uso: "asm" (compilado com -DPPOS_ASM_CONTEXT)
+// ou "ucontext" (getcontext/makecontext/swapcontext da glibc)
+const char *context_backend () ;
+
+// recupera a funcao e o argumento de um contexto preparado por makecontext
+// e ainda nao executado; retorna 0 em sucesso ou -1 se o backend/arquitetura
+// nao permite (usado para refazer o contexto sobre outra pilha)
+int context_entry (ucontext_t *ctx, void (**func)(void *), void **arg) ;
+
+// endereco da instrucao interrompida por um sinal, dado o terceiro
+// argumento de um tratador SA_SIGINFO; NULL se a arquitetura nao e suportada
+void *context_pc (void *uc) ;
+
+#endif
@@ -5,6 +5,15 @@
 #include <stdlib.h>
 #include "disk-driver.h"
 #include <string.h>
+#include "ppos-context.h"
+#include "ppos-stack.h"
+#include "ppos-wheel.h"
+#include "cqueue.h"
+#include <sys/select.h>
+#include <sys/time.h>
+#include <sys/auxv.h>
+#include <link.h>
+#include <time.h>
 
 // ****************************************************************************
 // Adicione TUDO O QUE FOR NECESSARIO para realizar o seu trabalho
@@ -14,14 +23,390 @@
 //
 // ****************************************************************************
 
-unsigned int _systemTime;
+volatile unsigned int _systemTime;
 static disk_t disk;
 static task_t disk_mgr_task;
 static diskrequest_t* current_request; 
 static long int disk_head_travel = 0;
+static volatile sig_atomic_t diskDone = 0;  // fim de transferencia a repassar
 
 void disk_signal_handler();
 void disk_mgr_body();
+static int disk_block_lower (heapnode_t* a, heapnode_t* b);
+
+// Extensao da TCB: tabela indexada pelo id da tarefa (ids nunca se repetem)
+static taskext_t** extTable = NULL;
+static int extTableSize = 0;
+
+// Tarefa encerrada ainda nao recolhida: ela continua executando sobre a
+// propria pilha ate trocar de contexto pela ultima vez em task_exit
+static task_t* zombieTask = NULL;
+static taskext_t* zombieExt = NULL;
+
+// Atributos repassados de task_create_attr para after_task_create
+static task_t* attrTask = NULL;
+static const task_attr_t* attrPending = NULL;
+
+// Chaves de armazenamento local de tarefa (task_key_create)
+static struct {
+    int used;
+    void (*destructor)(void*);
+} tlsKeys[PPOS_TLS_SLOTS];
+
+// Passagem direta do processador em sem_up/mutex_unlock (ppos_handoff):
+// a tarefa a acordar e anotada no before_* e recebe o processador no after_*,
+// ambos executados pelo nucleo com a preempcao desligada
+static int handoffEnabled = 0;
+static task_t* handoffTask = NULL;
+
+// > 0 enquanto um tratador de sinal do PPOS executa; nele nao se troca de tarefa
+static volatile int handlerDepth = 0;
+
+// Dispatcher ocioso (sem tarefas prontas): bloqueia o processo ate o proximo
+// sinal ou o proximo despertar na roda de tempo; com PPOS_IDLE_SPIN=1 gira como
+// o dispatcher original do nucleo. Os tempos sao medidos desde o ppos_init
+static int idleSpin = 0;
+static unsigned long long initTime = 0;      // instante do ppos_init (ns)
+static unsigned long long idleTime = 0;      // tempo ocioso acumulado (ns)
+
+// Relogio e preempcao por tempo. O tick (SIGALRM de ITIMER_REAL, a cada
+// TICK_US) atualiza _systemTime com o relogio monotonico, em ms desde o
+// ppos_init, e retira o processador da tarefa que esgotou o quantum. Com
+// PPOS_TICKLESS=1 nao ha tick periodico: systime() le o relogio e um
+// disparo unico do temporizador e armado para o fim do quantum. O quantum
+// e o da politica (sched_ops_t.quantum) ou o padrao, PPOS_QUANTUM ms; com
+// PPOS_QUANTUM=0 nao ha preempcao por tempo.
+#define TICK_US 1000
+static int tickless = 0;
+static int ticking = 0;                      // tick periodico armado
+static int defaultQuantum = PPOS_QUANTUM;    // quantum padrao (ms)
+static volatile int quantumActive = 0;       // a tarefa corrente tem quantum
+static volatile unsigned int quantumEnd = 0; // fim do quantum (systime)
+static volatile int tickSeen = 0;            // tick ja ocorreu nesta ativacao
+static volatile int timerArmed = 0;          // disparo unico pendente (tickless)
+static volatile unsigned int timerEnd = 0;   // instante desse disparo
+
+// Ativacao em curso, cujo processador o tick soma ao running_time da tarefa
+// corrente; NULL entre before_task_switch e after_task_switch, quando
+// lastActivation ainda nao e o da tarefa que esta entrando
+static task_t* volatile activeTask = NULL;
+static taskext_t* volatile activeExt = NULL;
+
+// running_time em ms: conta cada ms de processador iniciado, como o tick
+// periodico que o atualiza, entao o SRTF encerra a tarefa ao fim do tick em
+// que ela atinge o tempo estimado
+static int running_ms (unsigned long long ns) {
+    return (ns + 999999) / 1000000;
+}
+
+// Codigo do programa (definido pelo ligador); fora dele, p.ex. na libc,
+// a tarefa nao e preemptada: malloc e stdio nao sao reentrantes. A excecao
+// e o vDSO, onde fica o clock_gettime de systime_ns(), que e reentrante
+extern char __executable_start[], etext[];
+static char* vdsoStart = NULL;
+static char* vdsoEnd = NULL;
+
+taskext_t* task_ext (task_t* task) {
+    if (!task || task->id < 0 || task->id >= extTableSize)
+        return NULL;
+    return extTable[task->id];
+}
+
+// Os hooks que mexem nas estruturas do escalonador suspendem a preempcao
+// por tempo e a devolvem ao estado em que o nucleo os chamou
+unsigned char preempt_save () {
+    unsigned char old = preemption;
+    PPOS_PREEMPT_DISABLE
+    return old;
+}
+
+void preempt_restore (unsigned char old) {
+    PPOS_BARRIER;
+    preemption = old;
+    PPOS_BARRIER;
+}
+
+static taskext_t* task_ext_create (task_t* task) {
+    if (task->id >= extTableSize) {
+        int size = extTableSize ? extTableSize : 64;
+        while (size <= task->id)
+            size *= 2;
+        taskext_t** table = realloc(extTable, size * sizeof(taskext_t*));
+        if (!table) {
+            perror("Erro ao alocar tabela de extensoes de tarefas");
+            return NULL;
+        }
+        memset(table + extTableSize, 0, (size - extTableSize) * sizeof(taskext_t*));
+        extTable = table;
+        extTableSize = size;
+    }
+    extTable[task->id] = calloc(1, sizeof(taskext_t));
+    if (extTable[task->id]) {
+        extTable[task->id]->createTime = systime();
+        extTable[task->id]->eet = PPOS_DEFAULT_EET;
+        extTable[task->id]->tickets = PPOS_DEFAULT_TICKETS;
+    }
+    task->running_time = 0;
+    return extTable[task->id];
+}
+
+// Recolhe a ultima tarefa encerrada, desde que ela nao seja a corrente
+static void task_reap () {
+    if (!zombieExt || zombieTask == taskExec)
+        return;
+    stack_release(zombieExt->stack, zombieExt->stackSize);
+    free(zombieExt->name);
+    free(zombieExt);
+    zombieExt = NULL;
+    zombieTask = NULL;
+}
+
+// Troca a pilha alocada com malloc pelo task_create por uma do pool com
+// o tamanho pedido, refazendo o contexto (ainda nao executado) sobre ela
+static void task_stack_attach (task_t* task, taskext_t* ext, size_t size) {
+    void (*func)(void*);
+    void* arg;
+
+    if (context_entry(&task->context, &func, &arg) < 0)
+        return;
+    void* stack = stack_alloc(&size);
+    if (!stack)
+        return;
+
+    if (stack_paint_enabled())
+        stack_paint(stack, size);
+    free(task->context.uc_stack.ss_sp);
+    task->context.uc_stack.ss_sp = stack;
+    task->context.uc_stack.ss_size = size;
+    makecontext(&task->context, (void (*)(void)) func, 1, arg);
+    ext->stack = stack;
+    ext->stackSize = size;
+}
+
+void task_attr_init (task_attr_t* attr) {
+    attr->stackSize = STACKSIZE;
+    attr->prio = 0;
+    attr->name = NULL;
+    attr->group = NULL;
+}
+
+int task_create_attr (task_t* task, void (*start_func)(void*), void* arg,
+                      const task_attr_t* attr) {
+    attrTask = task;
+    attrPending = attr;
+    int id = task_create(task, start_func, arg);
+    attrTask = NULL;
+    attrPending = NULL;
+    return id;
+}
+
+const char* task_getname (task_t* task) {
+    taskext_t* ext = task_ext(task ? task : taskExec);
+    return ext ? ext->name : NULL;
+}
+
+void task_setprio (task_t* task, int prio) {
+    if (!task)
+        task = taskExec;
+    taskext_t* ext = task_ext(task);
+    if (!ext)
+        return;
+    if (prio < -20) prio = -20;
+    if (prio > 20) prio = 20;
+    ext->prio = prio;
+    // tarefa pronta: volta ao escalonador com a nova prioridade
+    if (ext->sched.queued) {
+        unsigned char old = preempt_save();
+        cpuSched->dequeue(task);
+        cpuSched->enqueue(task);
+        preempt_restore(old);
+    }
+}
+
+int task_getprio (task_t* task) {
+    taskext_t* ext = task_ext(task ? task : taskExec);
+    return ext ? ext->prio : 0;
+}
+
+// Cede o processador se a politica de escalonamento indicar que a tarefa
+// pronta deve executar antes da corrente (p.ex. SRTF com tempo restante menor)
+static void sched_preempt_check (task_t* task) {
+    if (taskExec == taskDisp || handlerDepth || !PPOS_IS_PREEMPT_ACTIVE)
+        return;
+    if (cpuSched->preempts(task))
+        task_yield();
+}
+
+void task_set_eet (task_t* task, int et) {
+    if (!task)
+        task = taskExec;
+    taskext_t* ext = task_ext(task);
+    if (!ext)
+        return;
+    ext->eet = et;
+    // tarefa pronta: volta ao escalonador com o novo tempo restante
+    if (ext->sched.queued) {
+        unsigned char old = preempt_save();
+        cpuSched->dequeue(task);
+        cpuSched->enqueue(task);
+        preempt_restore(old);
+        sched_preempt_check(task);
+    }
+}
+
+int task_get_eet (task_t* task) {
+    taskext_t* ext = task_ext(task ? task : taskExec);
+    return ext ? ext->eet : 0;
+}
+
+int task_get_ret (task_t* task) {
+    if (!task)
+        task = taskExec;
+    taskext_t* ext = task_ext(task);
+    if (!ext)
+        return 0;
+    // a tarefa corrente tambem consumiu a ativacao atual
+    int used = task->running_time;
+    if (task == taskExec)
+        used = running_ms(ext->cpuNs + systime_ns() - ext->lastActivation);
+    return ext->eet - used;
+}
+
+void task_set_tickets (task_t* task, int tickets) {
+    if (!task)
+        task = taskExec;
+    taskext_t* ext = task_ext(task);
+    if (!ext)
+        return;
+    ext->tickets = tickets < 1 ? 1 : tickets;
+    // tarefa pronta: volta ao escalonador com o novo passo
+    if (ext->sched.queued) {
+        unsigned char old = preempt_save();
+        cpuSched->dequeue(task);
+        cpuSched->enqueue(task);
+        preempt_restore(old);
+    }
+}
+
+int task_get_tickets (task_t* task) {
+    taskext_t* ext = task_ext(task ? task : taskExec);
+    return ext ? ext->tickets : 0;
+}
+
+int task_key_create (int* key, void (*destructor)(void*)) {
+    for (int k = 0; k < PPOS_TLS_SLOTS; k++)
+        if (!tlsKeys[k].used) {
+            tlsKeys[k].used = 1;
+            tlsKeys[k].destructor = destructor;
+            *key = k;
+            return 0;
+        }
+    return -1;
+}
+
+// Os valores das tarefas vivas sao descartados, para que uma chave criada
+// depois no mesmo indice comece em NULL e seu destrutor nao receba valores
+// da chave antiga
+int task_key_delete (int key) {
+    if (key < 0 || key >= PPOS_TLS_SLOTS || !tlsKeys[key].used)
+        return -1;
+    for (int i = 0; i < extTableSize; i++)
+        if (extTable[i])
+            extTable[i]->tls[key] = NULL;
+    tlsKeys[key].used = 0;
+    tlsKeys[key].destructor = NULL;
+    return 0;
+}
+
+int task_setspecific (int key, void* value) {
+    taskext_t* ext = task_ext(taskExec);
+    if (!ext || key < 0 || key >= PPOS_TLS_SLOTS || !tlsKeys[key].used)
+        return -1;
+    ext->tls[key] = value;
+    return 0;
+}
+
+void* task_getspecific (int key) {
+    taskext_t* ext = task_ext(taskExec);
+    if (!ext || key < 0 || key >= PPOS_TLS_SLOTS || !tlsKeys[key].used)
+        return NULL;
+    return ext->tls[key];
+}
+
+// Chama os destrutores dos valores locais da tarefa corrente; um destrutor
+// pode definir novos valores, entao repete algumas vezes como no POSIX
+static void task_tls_destroy () {
+    taskext_t* ext = task_ext(taskExec);
+    int pending = 1;
+
+    for (int round = 0; ext && pending && round < 4; round++) {
+        pending = 0;
+        for (int k = 0; k < PPOS_TLS_SLOTS; k++) {
+            void* value = ext->tls[k];
+            if (!value || !tlsKeys[k].used || !tlsKeys[k].destructor)
+                continue;
+            ext->tls[k] = NULL;
+            tlsKeys[k].destructor(value);
+            pending = 1;
+        }
+    }
+}
+
+// Marca a tarefa corrente como encerrada; seus recursos sao liberados
+// em task_reap, depois que ela deixar de executar
+static void task_ext_exit () {
+    taskext_t* ext = task_ext(taskExec);
+
+    task_reap();
+    if (!ext)
+        return;
+    extTable[taskExec->id] = NULL;
+    // o dispatcher faz free() da pilha; a do pool volta ao pool mais tarde
+    if (ext->stack)
+        taskExec->context.uc_stack.ss_sp = NULL;
+    zombieTask = taskExec;
+    zombieExt = ext;
+}
+
+int ppos_handoff (int enable) {
+    int old = handoffEnabled;
+    handoffEnabled = enable;
+    return old;
+}
+
+// Anota a tarefa que a operacao corrente vai acordar, se puder receber o
+// processador diretamente
+static void handoff_prepare (task_t* waiter) {
+    if (!handoffEnabled || handlerDepth || taskExec == taskDisp)
+        waiter = NULL;
+    handoffTask = waiter;
+}
+
+// Entrega o processador a tarefa acordada, que o nucleo acabou de mover
+// para a fila de prontas; a corrente vai para o fim da fila, como em task_yield
+static void handoff () {
+    task_t* task = handoffTask;
+
+    handoffTask = NULL;
+    if (!task || task->queue != (task_t*) &readyQueue)
+        return;
+
+    ring_remove((queue_t**) &readyQueue, (queue_t*) task);
+    cpuSched->dequeue(task);
+    task->queue = NULL;
+    task->state = 'e';
+
+    ring_append((queue_t**) &readyQueue, (queue_t*) taskExec);
+    taskExec->queue = (task_t*) &readyQueue;
+    taskExec->state = 'r';
+    cpuSched->enqueue(taskExec);
+
+    // o nucleo chamou o hook com a preempcao desligada e so a religa quando
+    // a tarefa corrente voltar; a acordada executa com ela ligada
+    tickSeen = 0;
+    PPOS_PREEMPT_ENABLE
+    task_switch(task);
+}
 
 int disk_mgr_init (int *numBlocks, int *blockSize) {
     if (disk_cmd (DISK_CMD_INIT, 0, 0) < 0) {
@@ -40,7 +425,9 @@ int disk_mgr_init (int *numBlocks, int *blockSize) {
     *numBlocks = disk.numBlocks;
     *blockSize = disk.blockSize;
 
-    disk.requestQueue = NULL;
+    cqueue_init(&disk.requestQueue);
+    heap_init(&disk.ahead, disk_block_lower);
+    heap_init(&disk.behind, disk_block_lower);
     disk.livre = 1;
     disk.head_pos = 0;
     disk.scheduling_policy = DISK_SCHED_FCFS;
@@ -69,62 +456,111 @@ int disk_mgr_init (int *numBlocks, int *blockSize) {
     return 0;
 }
 
-// Tratador de sinal para o sinal SIGUSR1, enviado pelo disco
+// Tratador de sinal para o sinal SIGUSR1, enviado pelo disco. O nucleo nao
+// bloqueia sinais nas operacoes de semaforo: um sem_up aqui pode interromper
+// o sem_down do gerente (ou o sem_up de disk_request) no mesmo semaforo e o
+// aviso se perde. O sem_up fica para o dispatcher (disk_deliver)
 void disk_signal_handler(int signum) {
-    disk.livre = 1;               
-    sem_up(&disk.work_semaphore);  
+    disk.livre = 1;
+    diskDone = 1;
+}
+
+// Repassa ao gerente de disco o fim de transferencia anotado pelo tratador
+static void disk_deliver () {
+    if (!diskDone)
+        return;
+    diskDone = 0;
+    sem_up(&disk.work_semaphore);
+}
+
+// Ordem dos pedidos nos heaps do escalonador de disco: bloco crescente ou
+// decrescente, e ordem de chegada nos empates
+static int disk_block_lower (heapnode_t* a, heapnode_t* b) {
+    diskrequest_t* x = heap_entry(a, diskrequest_t, heap);
+    diskrequest_t* y = heap_entry(b, diskrequest_t, heap);
+    if (x->block != y->block)
+        return x->block < y->block;
+    return x->seq < y->seq;
+}
+
+static int disk_block_higher (heapnode_t* a, heapnode_t* b) {
+    diskrequest_t* x = heap_entry(a, diskrequest_t, heap);
+    diskrequest_t* y = heap_entry(b, diskrequest_t, heap);
+    if (x->block != y->block)
+        return x->block > y->block;
+    return x->seq < y->seq;
 }
 
-// O escalonador de disco
+// Poe o pedido no heap do seu lado da cabeca (SSTF e C-SCAN). Os pedidos a
+// frente saem pelo menor bloco; os de tras, pelo maior no SSTF (o mais
+// proximo) e pelo menor no C-SCAN (o primeiro depois da volta). Como a
+// cabeca so vai para o topo de um dos heaps, cada pedido continua do seu
+// lado sem ser reclassificado
+static int disk_heap_add (diskrequest_t* request) {
+    if (disk.scheduling_policy != DISK_SCHED_SSTF &&
+        disk.scheduling_policy != DISK_SCHED_CSCAN)
+        return 0;
+    return heap_insert(request->block >= disk.head_pos ? &disk.ahead : &disk.behind,
+                       &request->heap);
+}
+
+static void disk_heap_del (diskrequest_t* request) {
+    if (heap_contains(&disk.ahead, &request->heap))
+        heap_remove(&disk.ahead, &request->heap);
+    else if (heap_contains(&disk.behind, &request->heap))
+        heap_remove(&disk.behind, &request->heap);
+}
+
+// Refaz os heaps para a politica em uso, a partir da fila de pedidos
+static void disk_heap_rebuild () {
+    queue_t* first = cqueue_first(&disk.requestQueue);
+    queue_t* elem = first;
+
+    heap_clear(&disk.ahead);
+    heap_clear(&disk.behind);
+    disk.behind.before = disk.scheduling_policy == DISK_SCHED_SSTF ?
+                         disk_block_higher : disk_block_lower;
+    if (elem) {
+        do {
+            disk_heap_add((diskrequest_t*) elem);
+            elem = elem->next;
+        } while (elem != first);
+    }
+}
+
+// O escalonador de disco: o FCFS atende a fila de pedidos na ordem; o SSTF
+// e o C-SCAN escolhem no topo dos heaps, em O(log n)
 diskrequest_t* disk_scheduler() {
-    diskrequest_t* next_request = NULL;
-    if (!disk.requestQueue) return NULL;
+    heapnode_t* up = heap_first(&disk.ahead);
+    heapnode_t* down = heap_first(&disk.behind);
+
+    if (!cqueue_size(&disk.requestQueue)) return NULL;
+    // FCFS, ou pedidos fora dos heaps por falta de memoria
+    if (!up && !down)
+        return (diskrequest_t*) cqueue_first(&disk.requestQueue);
 
     switch (disk.scheduling_policy) {
         case DISK_SCHED_SSTF: {
-            diskrequest_t* best_request = (diskrequest_t*)disk.requestQueue;
-            int min_distance = abs(best_request->block - disk.head_pos);
-            diskrequest_t* current_item = best_request->next;
-            while(current_item != (diskrequest_t*)disk.requestQueue) {
-                int distance = abs(current_item->block - disk.head_pos);
-                if (distance < min_distance) {
-                    min_distance = distance;
-                    best_request = current_item;
-                }
-                current_item = current_item->next;
+            // o mais proximo de cada lado; no empate, o da frente
+            if (!up || !down)
+                return heap_entry(up ? up : down, diskrequest_t, heap);
+            diskrequest_t* fwd = heap_entry(up, diskrequest_t, heap);
+            diskrequest_t* back = heap_entry(down, diskrequest_t, heap);
+            return fwd->block - disk.head_pos <= disk.head_pos - back->block ? fwd : back;
+        }
+        case DISK_SCHED_CSCAN:
+            // sem pedidos a frente, a cabeca volta ao inicio e os de tras
+            // passam a estar a frente
+            if (!up) {
+                heap_t aux = disk.ahead;
+                disk.ahead = disk.behind;
+                disk.behind = aux;
+                up = down;
             }
-            next_request = best_request;
-        } break;
-        case DISK_SCHED_CSCAN: {
-            diskrequest_t* current_item = (diskrequest_t*)disk.requestQueue;
-            diskrequest_t* best_fwd = NULL;
-            int min_dist_fwd = -1;
-            diskrequest_t* best_wrap = NULL;
-            int min_block_wrap = -1;
-            do {
-                if (current_item->block >= disk.head_pos) {
-                    int dist = current_item->block - disk.head_pos;
-                    if (min_dist_fwd == -1 || dist < min_dist_fwd) {
-                        min_dist_fwd = dist;
-                        best_fwd = current_item;
-                    }
-                }
-                if (min_block_wrap == -1 || current_item->block < min_block_wrap) {
-                    min_block_wrap = current_item->block;
-                    best_wrap = current_item;
-                }
-                current_item = current_item->next;
-            } while (current_item != (diskrequest_t*)disk.requestQueue);
-
-            if (best_fwd) next_request = best_fwd;
-            else next_request = best_wrap;
-        } break;
-        case DISK_SCHED_FCFS:
+            return heap_entry(up, diskrequest_t, heap);
         default:
-            next_request = (diskrequest_t*)disk.requestQueue;
-            break;
+            return (diskrequest_t*) cqueue_first(&disk.requestQueue);
     }
-    return next_request;
 }
 
 // Corpo da tarefa gerenciadora de disco
@@ -135,15 +571,16 @@ void disk_mgr_body(void* arg) {
         sem_down(&disk.semaforo);
 
         if (current_request && disk.livre) {
-            task_resume(current_request->task);
+            future_complete(current_request->future, 0);
             free(current_request);             
             current_request = NULL;
         }
 
-        if (disk.livre && queue_size((queue_t*)disk.requestQueue) > 0) {
+        if (disk.livre && cqueue_size(&disk.requestQueue) > 0) {
             diskrequest_t* next_req_ptr = disk_scheduler();
             if (next_req_ptr) {
-                current_request = (diskrequest_t*)queue_remove((queue_t**)&disk.requestQueue, (queue_t*)next_req_ptr);
+                current_request = (diskrequest_t*)cqueue_remove(&disk.requestQueue, (queue_t*)next_req_ptr);
+                disk_heap_del(current_request);
                 disk.livre = 0;
                 fflush(stdout);
                 int distance = abs(disk.head_pos - current_request->block);
@@ -153,7 +590,8 @@ void disk_mgr_body(void* arg) {
             }
         }
 
-        if (taskMain->state == PPOS_TASK_STATE_TERMINATED && queue_size((queue_t*)disk.requestQueue) == 0) {
+        // o nucleo marca a tarefa encerrada com 'x'
+        if (taskMain->state == 'x' && !current_request && cqueue_size(&disk.requestQueue) == 0) {
             sem_up(&disk.semaforo); 
             task_exit(0);           
         }
@@ -164,44 +602,60 @@ void disk_mgr_body(void* arg) {
     }
 }
 
-// API de leitura de bloco do disco
-int disk_block_read (int block, void *buffer) {
+// Enfileira um pedido ao disco; o futuro f e concluido ao fim da transferencia
+static int disk_request (unsigned char operation, int block, void *buffer, future_t *f) {
     fflush(stdout);
+    if (!f || f->done)
+        return -1;
     diskrequest_t* request = malloc(sizeof(diskrequest_t));
     if (!request) return -1;
-    request->operation = DISK_CMD_READ;
+    // um elemento fora de fila tem os ponteiros nulos
+    request->next = request->prev = NULL;
+    request->operation = operation;
     request->block = block;
     request->buffer = buffer;
     request->task = taskExec;
+    request->future = f;
     sem_down(&disk.semaforo);
-    queue_append((queue_t**)&disk.requestQueue, (queue_t*)request);
+    request->seq = disk.arrivals++;
+    cqueue_append(&disk.requestQueue, (queue_t*)request);
+    // fora dos heaps, o pedido ainda e atendido quando eles se esvaziarem
+    if (disk_heap_add(request) < 0)
+        perror("Erro ao alocar o heap do escalonador de disco");
     sem_up(&disk.semaforo);
     sem_up(&disk.work_semaphore);
-    task_suspend(taskExec, NULL);
     return 0;
 }
 
+int disk_block_read_async (int block, void *buffer, future_t *f) {
+    return disk_request(DISK_CMD_READ, block, buffer, f);
+}
+
+int disk_block_write_async (int block, void *buffer, future_t *f) {
+    return disk_request(DISK_CMD_WRITE, block, buffer, f);
+}
+
+// API de leitura de bloco do disco
+int disk_block_read (int block, void *buffer) {
+    future_t done;
+    future_create(&done);
+    if (disk_block_read_async(block, buffer, &done) < 0) return -1;
+    return future_await(&done);
+}
+
 // API de escrita de bloco no disco
 int disk_block_write (int block, void *buffer) {
-    fflush(stdout);
-    diskrequest_t* request = malloc(sizeof(diskrequest_t));
-    if (!request) return -1;
-    request->operation = DISK_CMD_WRITE;
-    request->block = block;
-    request->buffer = buffer;
-    request->task = taskExec;
-    sem_down(&disk.semaforo);
-    queue_append((queue_t**)&disk.requestQueue, (queue_t*)request);
-    sem_up(&disk.semaforo);
-    sem_up(&disk.work_semaphore);
-    task_suspend(taskExec, NULL);
-    return 0;
+    future_t done;
+    future_create(&done);
+    if (disk_block_write_async(block, buffer, &done) < 0) return -1;
+    return future_await(&done);
 }
 
 // Define a política de escalonamento a ser usada
 void disk_set_scheduler(int policy) {
     sem_down(&disk.semaforo);
     disk.scheduling_policy = policy;
+    disk_heap_rebuild();
     sem_up(&disk.semaforo);
 }
 
@@ -217,13 +671,350 @@ long int disk_head_travel_get() {
     return disk_head_travel;
 }
 
+// Politica FIFO: nao mantem indice algum, e scheduler() segue a ordem de
+// readyQueue
+static void fifo_init () {}
+static void fifo_task (task_t* task) {}
+static void fifo_turn_end () {}
+static task_t* fifo_pick () { return NULL; }
+static int fifo_preempts (task_t* task) { return 0; }
+static void fifo_switch (task_t* prev, task_t* next) {}
+static int fifo_quantum (task_t* task) { return 0; }
+
+const sched_ops_t sched_fifo = {
+    .name      = "FIFO",
+    .init      = fifo_init,
+    .enqueue   = fifo_task,
+    .dequeue   = fifo_task,
+    .exit      = fifo_task,
+    .turn_end  = fifo_turn_end,
+    .pick      = fifo_pick,
+    .preempts  = fifo_preempts,
+    .switch_to = fifo_switch,
+    .quantum   = fifo_quantum
+};
+
+// Politicas de escalonamento do processador, indexadas por PPOS_SCHED_*
+static const sched_ops_t* const schedPolicies[] = {
+    [PPOS_SCHED_FIFO]   = &sched_fifo,
+    [PPOS_SCHED_PRIO]   = &sched_prio,
+    [PPOS_SCHED_SRTF]   = &sched_srtf,
+    [PPOS_SCHED_CFS]    = &sched_cfs,
+    [PPOS_SCHED_MLFQ]   = &sched_mlfq,
+    [PPOS_SCHED_STRIDE] = &sched_stride,
+};
+#define SCHED_POLICIES (int) (sizeof(schedPolicies) / sizeof(schedPolicies[0]))
+
+const sched_ops_t* cpuSched = NULL;
+int schedReport = 0;
+
+// Escolhe a politica pelo nome em PPOS_CPU_SCHED, ou a definida na
+// compilacao (PPOS_CPU_SCHED) se a variavel nao existir ou for invalida
+static void sched_select () {
+    char* name = getenv("PPOS_CPU_SCHED");
+
+    cpuSched = schedPolicies[PPOS_CPU_SCHED];
+    if (!name || !*name)
+        return;
+    for (int i = 0; i < SCHED_POLICIES; i++)
+        if (strcmp(name, schedPolicies[i]->name) == 0) {
+            cpuSched = schedPolicies[i];
+            return;
+        }
+    fprintf(stderr, "PPOS: politica de escalonamento %s desconhecida, usando %s\n",
+            name, cpuSched->name);
+}
+
+const char* ppos_sched_name () {
+    return cpuSched ? cpuSched->name : NULL;
+}
+
 task_t* scheduler() {
-    return readyQueue; 
+    task_reap();
+    task_t* next = cpuSched->pick();
+    // tarefa que entrou em readyQueue sem passar pelos hooks (p.ex. uma
+    // tarefa ja encerrada retomada com task_resume): segue a ordem da fila
+    return next ? next : readyQueue;
+}
+
+static unsigned long long clock_ns (clockid_t clock) {
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+unsigned long long systime_ns () {
+    if (!initTime)
+        return 0;
+    return clock_ns(CLOCK_MONOTONIC) - initTime;
+}
+
+unsigned long long systime_us () {
+    return systime_ns() / 1000;
+}
+
+// ms do relogio monotonico desde o ppos_init (0 antes dele)
+static unsigned int clock_ms () {
+    return systime_ns() / 1000000;
+}
+
+// Arma o temporizador para um disparo unico daqui a ms (modo tickless)
+static void tick_arm (unsigned int ms) {
+    struct itimerval timer = { { 0, 0 }, { ms / 1000, (ms % 1000) * 1000 } };
+
+    timerArmed = 1;
+    timerEnd = systime() + ms;
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+// Garante, no modo tickless, um disparo do temporizador ate o instante when
+void tick_wake (unsigned int when) {
+    int ms = (int) (when - systime());
+
+    if (!tickless || !quantumActive)
+        return;
+    if (!timerArmed || (int) (timerEnd - when) > 0)
+        tick_arm(ms > 1 ? ms : 1);
+}
+
+// Inicia o quantum da tarefa que recebeu o processador
+static void quantum_start (task_t* task) {
+    int q = cpuSched->quantum(task);
+    unsigned int due;
+
+    if (!q)
+        q = defaultQuantum;
+    quantumActive = (defaultQuantum > 0 && q > 0);
+    tickSeen = 0;
+    if (!quantumActive)
+        return;
+    quantumEnd = systime() + q;
+    // no modo tickless, um disparo anterior ao fim do quantum ja serve; a
+    // roda de tempo pode pedir um ainda antes
+    if (tickless) {
+        tick_wake(quantumEnd);
+        if (wheel_next(&due))
+            tick_wake(due);
+    }
+}
+
+// Retira o processador da tarefa corrente se o quantum dela se esgotou ou
+// se ha algo vencido na roda de tempo (despertar ou temporizador, tratados
+// pelo dispatcher); pc e a instrucao interrompida pelo tick. O primeiro tick
+// de cada ativacao so e anotado: ele pode chegar entre a troca de taskExec e
+// a troca de pilha em task_switch, quando a nova tarefa ainda nao executa.
+// Se o nucleo ou um hook estiver em secao critica, ou a tarefa estiver fora
+// do codigo do programa, a preempcao fica para o tick seguinte.
+static void tick_preempt (unsigned int now, char* pc) {
+    int left = (int) (quantumEnd - now);
+    int outside = pc && (pc < __executable_start || pc >= etext) &&
+                  (pc < vdsoStart || pc >= vdsoEnd);
+    unsigned int due;
+
+    if (taskExec == taskDisp || !quantumActive)
+        return;
+    // a roda so e lida aqui; um valor inconsistente, se uma tarefa a
+    // altera, so antecipa ou atrasa a preempcao
+    if (wheel_next(&due) && (int) (due - now) < left)
+        left = (int) (due - now);
+    if (!tickSeen || left > 0 || outside || handlerDepth || !PPOS_IS_PREEMPT_ACTIVE) {
+        tickSeen = 1;
+        if (tickless && !timerArmed)
+            tick_arm(left > 1 ? left : 1);
+        return;
+    }
+    tickSeen = 0;
+    task_yield();
+}
+
+// Tratador do tick (SIGALRM); instalado com SA_NODEFER, pois a tarefa
+// preemptada troca de contexto dentro dele e o backend assembly nao
+// restaura a mascara de sinais
+static void tick_handler (int signum, siginfo_t* info, void* uc) {
+    unsigned int now;
+
+    handlerDepth++;
+    now = _systemTime = clock_ms();
+    if (tickless)
+        timerArmed = 0;
+    // running_time passa a incluir a ativacao corrente
+    if (activeTask && activeTask == taskExec)
+        activeTask->running_time = running_ms(activeExt->cpuNs + systime_ns() -
+                                              activeExt->lastActivation);
+    handlerDepth--;
+    tick_preempt(now, context_pc(uc));
+}
+
+// Limites do vDSO, do cabecalho ELF que o kernel mapeia no processo
+static void vdso_bounds () {
+    ElfW(Ehdr)* ehdr = (ElfW(Ehdr)*) getauxval(AT_SYSINFO_EHDR);
+    ElfW(Phdr)* phdr;
+
+    if (!ehdr)
+        return;
+    phdr = (ElfW(Phdr)*) ((char*) ehdr + ehdr->e_phoff);
+    for (int i = 0; i < ehdr->e_phnum; i++)
+        if (phdr[i].p_type == PT_LOAD) {
+            vdsoStart = (char*) ehdr;
+            vdsoEnd = (char*) ehdr + phdr[i].p_offset + phdr[i].p_memsz;
+            return;
+        }
+}
+
+// Instala o tratador do tick e, fora do modo tickless, arma o tick periodico
+static void tick_start () {
+    struct sigaction action;
+    struct itimerval timer = { { 0, TICK_US }, { 0, TICK_US } };
+
+    if (tickless && defaultQuantum <= 0)
+        return;
+    vdso_bounds();
+    action.sa_sigaction = tick_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_SIGINFO | SA_RESTART | SA_NODEFER;
+    if (sigaction(SIGALRM, &action, NULL) < 0) {
+        perror("Erro em sigaction");
+        exit(1);
+    }
+    if (tickless)
+        return;
+    if (setitimer(ITIMER_REAL, &timer, NULL) < 0) {
+        perror("Erro em setitimer");
+        exit(1);
+    }
+    ticking = 1;
 }
 
-// Implementação mínima de systime()
+// Despertar de task_sleep vencido na roda de tempo
+static void sleep_expire (wheelnode_t* node) {
+    task_resume((task_t*) node->arg);
+}
+
+// Passa para a roda de tempo uma tarefa que task_sleep deixou em sleepQueue
+static void sleep_arm (task_t* task) {
+    taskext_t* ext = task_ext(task);
+
+    if (!ext || task->queue != (task_t*) &sleepQueue)
+        return;
+    ring_remove((queue_t**) &sleepQueue, (queue_t*) task);
+    task->queue = NULL;
+    ext->sleep.expire = sleep_expire;
+    ext->sleep.arg = task;
+    wheel_add(&ext->sleep, task->awakeTime);
+    tick_wake(task->awakeTime);
+}
+
+// Acorda as tarefas cujo instante de despertar ja passou. Uma tarefa ainda
+// em sleepQueue vai para a roda; as sem extensao ficam la e sao testadas
+// uma a uma
+static void dispatcher_wake () {
+    task_t* task = sleepQueue;
+    task_t* last = task ? task->prev : NULL;
+    unsigned int now = systime();
+
+    // sleep_arm e task_resume retiram a tarefa de sleepQueue: guarda a
+    // proxima antes, e para apos a ultima sem contar a fila
+    while (task) {
+        task_t* next = (task == last) ? NULL : task->next;
+        if (task_ext(task))
+            sleep_arm(task);
+        else if (task->awakeTime <= now)
+            task_resume(task);
+        task = next;
+    }
+    wheel_advance(now);
+}
+
+// Espera ate haver uma tarefa pronta: um sinal (p.ex. o do disco) pode
+// acorda-la, ou o proximo despertar vencer. Os sinais ficam
+// bloqueados entre o teste de readyQueue e o pselect, que os desbloqueia
+// atomicamente; assim um sinal nesse intervalo nao se perde.
+static void dispatcher_idle () {
+    unsigned long long start = clock_ns(CLOCK_MONOTONIC);
+    struct timespec timeout, *wait;
+    sigset_t all, old;
+
+    if (idleSpin) {
+        while (!readyQueue) {
+            disk_deliver();
+            dispatcher_wake();
+        }
+        idleTime += clock_ns(CLOCK_MONOTONIC) - start;
+        return;
+    }
+
+    sigfillset(&all);
+    sigprocmask(SIG_BLOCK, &all, &old);
+    disk_deliver();
+    dispatcher_wake();
+    if (!readyQueue) {
+        // prazo do despertar mais proximo, em ms de systime()
+        unsigned int next, now = systime();
+        int pending = wheel_next(&next);
+        task_t* task = sleepQueue;
+
+        if (task) {
+            do {
+                if (!pending || (int) (task->awakeTime - next) < 0)
+                    next = task->awakeTime;
+                pending = 1;
+                task = task->next;
+            } while (task != sleepQueue);
+        }
+        wait = NULL;
+        if (pending) {
+            next = (int) (next - now) > 0 ? next - now : 0;
+            timeout.tv_sec = next / 1000;
+            timeout.tv_nsec = (next % 1000) * 1000000L;
+            wait = &timeout;
+        }
+        pselect(0, NULL, NULL, NULL, wait, &old);
+    }
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    idleTime += clock_ns(CLOCK_MONOTONIC) - start;
+}
+
+// Corpo do dispatcher, no lugar do bodyDispatcher do nucleo (ver
+// after_task_create): mesmo laco, mas sem girar quando nao ha tarefas prontas
+static void dispatcher_body (void* arg) {
+    while (countTasks > 0) {
+        disk_deliver();
+        dispatcher_wake();
+        if (readyQueue) {
+            task_t* next = scheduler();
+            if (next) {
+                ring_remove((queue_t**) &readyQueue, (queue_t*) next);
+                next->queue = NULL;
+                next->state = 'e';     // "em execucao", como no nucleo
+                task_switch(next);
+                // pilha da tarefa encerrada (NULL se for do pool)
+                if (freeTask) {
+                    free(freeTask->context.uc_stack.ss_sp);
+                    freeTask = NULL;
+                }
+            }
+        }
+        else
+            dispatcher_idle();
+    }
+    task_exit(0);
+}
+
+void ppos_idle_stats (unsigned int* wall, unsigned int* idle, unsigned int* cpu) {
+    if (wall)
+        *wall = systime_ns() / 1000000;
+    if (idle)
+        *idle = idleTime / 1000000;
+    if (cpu)
+        *cpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID) / 1000000;
+}
+
+// ms desde o ppos_init: com o tick periodico, o valor que ele atualizou
 unsigned int systime() {
-    return _systemTime; 
+    if (!ticking)
+        _systemTime = clock_ms();
+    return _systemTime;
 }
 
 int disk_get_num_blocks() {
@@ -232,6 +1023,26 @@ int disk_get_num_blocks() {
 
 void before_ppos_init () {
     char* policy_str = getenv("PPOS_SCHEDULER");
+    char* handoff_str = getenv("PPOS_HANDOFF");
+    char* spin_str = getenv("PPOS_IDLE_SPIN");
+    char* quantum_str = getenv("PPOS_QUANTUM");
+    char* tickless_str = getenv("PPOS_TICKLESS");
+    char* report_str = getenv("PPOS_SCHED_REPORT");
+
+    if (handoff_str && strcmp(handoff_str, "1") == 0)
+        handoffEnabled = 1;
+    if (spin_str && strcmp(spin_str, "1") == 0)
+        idleSpin = 1;
+    if (quantum_str && atoi(quantum_str) >= 0)
+        defaultQuantum = atoi(quantum_str);
+    if (tickless_str && strcmp(tickless_str, "1") == 0)
+        tickless = 1;
+    if (report_str && strcmp(report_str, "1") == 0)
+        schedReport = 1;
+    initTime = clock_ns(CLOCK_MONOTONIC);
+    wheel_init(systime());
+    sched_select();
+    cpuSched->init();
 
     if (policy_str) { 
         if (strcmp(policy_str, "SSTF") == 0) {
@@ -246,7 +1057,16 @@ void before_ppos_init () {
 }
 
 void after_ppos_init () {
-    // put your customization here
+    taskext_t* ext = task_ext_create(taskMain);
+    // main ja esta executando
+    if (ext) {
+        ext->activations = 1;
+        ext->lastActivation = systime_ns();
+    }
+    if (taskMain->queue == (task_t*) &readyQueue)
+        cpuSched->enqueue(taskMain);
+    tick_start();
+    quantum_start(taskMain);
 #ifdef DEBUG
     printf("\ninit - AFTER");
 #endif
@@ -254,14 +1074,45 @@ void after_ppos_init () {
 }
 
 void before_task_create (task_t *task ) {
-    // put your customization here
+    unsigned char old = preempt_save();
+    task_reap();
+    preempt_restore(old);
+    // uma TCB nova nao esta em fila alguma; queue_append recusa elementos
+    // com ponteiros nao nulos (p.ex. TCB obtida com malloc sem zerar)
+    task->prev = task->next = NULL;
 #ifdef DEBUG
     printf("\ntask_create - BEFORE - [%d]", task->id);
 #endif
 }
 
 void after_task_create (task_t *task ) {
-    // put your customization here
+    const task_attr_t* attr = (task == attrTask) ? attrPending : NULL;
+    unsigned char old = preempt_save();
+    taskext_t* ext = task_ext_create(task);
+    if (ext) {
+        task_stack_attach(task, ext, (attr && attr->stackSize) ? attr->stackSize : STACKSIZE);
+        if (attr) {
+            ext->name = attr->name ? strdup(attr->name) : NULL;
+            task_setprio(task, attr->prio);
+            if (attr->group && attr->group->active) {
+                ext->group = attr->group;
+                ext->group->members++;
+                ext->group->running++;
+            }
+        }
+    }
+    // o dispatcher do nucleo gira enquanto nao ha tarefas prontas; o seu
+    // contexto, ainda nao executado, passa a usar dispatcher_body
+    if (task == taskDisp) {
+        makecontext(&task->context, (void (*)(void)) dispatcher_body, 1, NULL);
+        preempt_restore(old);
+    }
+    // o dispatcher e retirado de readyQueue pelo ppos_init
+    else {
+        cpuSched->enqueue(task);
+        preempt_restore(old);
+        sched_preempt_check(task);
+    }
 #ifdef DEBUG
     printf("\ntask_create - AFTER - [%d]", task->id);
 #endif
@@ -269,7 +1120,7 @@ void after_task_create (task_t *task ) {
 }
 
 void before_task_exit () {
-    // put your customization here
+    task_tls_destroy();
 #ifdef DEBUG
     printf("\ntask_exit - BEFORE - [%d]", taskExec->id);
 #endif
@@ -295,11 +1146,37 @@ void after_task_exit () {
         printf("  Relatorio de Desempenho do Disco:\n");
         printf("  Politica Executada: %s\n", policy_name);
         printf("  -> Tempo total de execucao: %u ms\n", final_time);
+        // o gerente de disco termina quando main termina sem pedidos pendentes
+        if (disk_mgr_task.state)
+            sem_up(&disk.work_semaphore);
     }
+    unsigned char old = preempt_save();
+    taskext_t* ext = task_ext(taskExec);
+    if (ext && ext->stack && stack_paint_enabled())
+        printf("PPOS: tarefa %d usou %ld de %ld bytes de pilha\n", taskExec->id,
+               (long) stack_peak(ext->stack, ext->stackSize), (long) ext->stackSize);
+    future_task_exit();
+    group_task_exit();
+    // o no do escalonador fica na extensao, que sera liberada
+    cpuSched->exit(taskExec);
+    cpuSched->dequeue(taskExec);
+    cpuSched->turn_end();
+    task_ext_exit();
+    preempt_restore(old);
 }
 
 void before_task_switch ( task_t *task ) {
-    // put your customization here
+    unsigned char old = preempt_save();
+    cpuSched->switch_to(taskExec, task);
+    // contabiliza o processador usado pela tarefa que sai
+    taskext_t* ext = task_ext(taskExec);
+    activeTask = NULL;
+    if (ext) {
+        ext->cpuNs += systime_ns() - ext->lastActivation;
+        ext->cpuTime = ext->cpuNs / 1000000;
+        taskExec->running_time = running_ms(ext->cpuNs);
+    }
+    preempt_restore(old);
 #ifdef DEBUG
     printf("\ntask_switch - BEFORE - [%d -> %d]", taskExec->id, task->id);
 #endif
@@ -307,7 +1184,17 @@ void before_task_switch ( task_t *task ) {
 }
 
 void after_task_switch ( task_t *task ) {
-    _systemTime++;
+    unsigned char old = preempt_save();
+    taskext_t* ext = task_ext(task);
+    if (ext) {
+        ext->activations++;
+        ext->lastActivation = systime_ns();
+        activeExt = ext;
+        activeTask = task;
+    }
+    if (task != taskDisp)
+        quantum_start(task);
+    preempt_restore(old);
 #ifdef DEBUG
     printf("\ntask_switch - AFTER - [%d -> %d]", taskExec->id, task->id);
 #endif
@@ -320,7 +1207,13 @@ void before_task_yield () {
 #endif
 }
 void after_task_yield () {
-    // put your customization here
+    // task_yield nao recoloca em readyQueue uma tarefa suspensa
+    if (taskExec && taskExec->state == 'r') {
+        unsigned char old = preempt_save();
+        cpuSched->enqueue(taskExec);
+        cpuSched->turn_end();
+        preempt_restore(old);
+    }
 #ifdef DEBUG
     printf("\ntask_yield - AFTER - [%d]", taskExec->id);
 #endif
@@ -335,21 +1228,33 @@ void before_task_suspend( task_t *task ) {
 }
 
 void after_task_suspend( task_t *task ) {
-    // put your customization here
+    unsigned char old = preempt_save();
+    cpuSched->dequeue(task);
+    preempt_restore(old);
 #ifdef DEBUG
     printf("\ntask_suspend - AFTER - [%d]", task->id);
 #endif
 }
 
 void before_task_resume(task_t *task) {
-    // put your customization here
+    taskext_t* ext = task_ext(task);
+    unsigned char old = preempt_save();
+
+    // retomada antes do prazo: o despertar deixa a roda de tempo
+    if (ext && wheel_pending(&ext->sleep))
+        wheel_del(&ext->sleep);
+    preempt_restore(old);
 #ifdef DEBUG
     printf("\ntask_resume - BEFORE - [%d]", task->id);
 #endif
 }
 
 void after_task_resume(task_t *task) {
-    // put your customization here
+    if (task->queue == (task_t*) &readyQueue) {
+        unsigned char old = preempt_save();
+        cpuSched->enqueue(task);
+        preempt_restore(old);
+    }
 #ifdef DEBUG
     printf("\ntask_resume - AFTER - [%d]", task->id);
 #endif
@@ -363,7 +1268,9 @@ void before_task_sleep () {
 }
 
 void after_task_sleep () {
-    // put your customization here
+    PPOS_PREEMPT_DISABLE
+    sleep_arm(taskExec);
+    PPOS_PREEMPT_ENABLE
 #ifdef DEBUG
     printf("\ntask_sleep - AFTER - [%d]", taskExec->id);
 #endif
@@ -419,7 +1326,8 @@ int after_sem_down (semaphore_t *s) {
 }
 
 int before_sem_up (semaphore_t *s) {
-    // put your customization here
+    // sem_up acorda a primeira tarefa da fila se o valor continuar <= 0
+    handoff_prepare(s->value + 1 <= 0 ? s->queue : NULL);
 #ifdef DEBUG
     printf("\nsem_up - BEFORE - [%d]", taskExec->id);
 #endif
@@ -427,7 +1335,7 @@ int before_sem_up (semaphore_t *s) {
 }
 
 int after_sem_up (semaphore_t *s) {
-    // put your customization here
+    handoff();
 #ifdef DEBUG
     printf("\nsem_up - AFTER - [%d]", taskExec->id);
 #endif
@@ -483,7 +1391,8 @@ int after_mutex_lock (mutex_t *m) {
 }
 
 int before_mutex_unlock (mutex_t *m) {
-    // put your customization here
+    // mutex_unlock passa o mutex para a primeira tarefa da fila, se houver
+    handoff_prepare(m->queue);
 #ifdef DEBUG
     printf("\nmutex_unlock - BEFORE - [%d]", taskExec->id);
 #endif
@@ -491,7 +1400,7 @@ int before_mutex_unlock (mutex_t *m) {
 }
 
 int after_mutex_unlock (mutex_t *m) {
-    // put your customization here
+    handoff();
 #ifdef DEBUG
     printf("\nmutex_unlock - AFTER - [%d]", taskExec->id);
 #endif
@@ -11,9 +11,69 @@ extern task_t* sleepQueue; // Ponteiro para a fila de tarefas dormindo
 //extern task_t* taskDiskMgr; // Ponterio para a tarefa gerente do disco
 extern long nextid;        // Valor do proximo ID a ser usado pelo task_create()
 extern long countTasks;    // Total de tarefas de usuario
-extern unsigned char preemption; // indica se pode haver preempcao no momento. 
+extern volatile unsigned char preemption; // indica se pode haver preempcao no momento. 
                                 // Valor 1 indica que a preempcao esta habilido, 
                                 // qualquer outro valor indica desabilitado
-extern unsigned int _systemTime; // armazena o tempo global do sistema, em ticks do relogio
+extern volatile unsigned int _systemTime; // armazena o tempo global do sistema, em ticks do relogio
+
+// Extensao da TCB (ver taskext_t em ppos-data.h); NULL se a tarefa ja
+// foi recolhida ou nao e conhecida
+taskext_t* task_ext (task_t* task);
+
+// Suspende a preempcao por tempo e retorna o estado anterior, que
+// preempt_restore devolve; para trechos que podem ser chamados com a
+// preempcao ja desligada (hooks, task_exit, dispatcher)
+unsigned char preempt_save ();
+void preempt_restore (unsigned char old);
+
+// Garante um tick ate o instante when (systime), no modo tickless; a roda
+// de tempo pode ser usada por outros modulos (ver ppos-wheel.h), e quem a
+// arma chama esta funcao
+void tick_wake (unsigned int when);
+
+// Conclui os futuros ligados a tarefa corrente (ver future_task)
+void future_task_exit ();
+
+// Contabiliza no grupo o termino da tarefa corrente (ver group_task_create)
+void group_task_exit ();
+
+// Politica de escalonamento do processador: indice das tarefas prontas,
+// mantido em paralelo a readyQueue (ver ppos-sched.c). A politica em uso e
+// escolhida no ppos_init pela variavel de ambiente PPOS_CPU_SCHED.
+typedef struct sched_ops_t
+{
+   const char* name;			// nome em PPOS_CPU_SCHED
+   // inicializa a politica (chamada em before_ppos_init)
+   void (*init) ();
+   // a tarefa entrou/saiu de readyQueue
+   void (*enqueue) (task_t* task);
+   void (*dequeue) (task_t* task);
+   // a tarefa corrente terminou (task_exit)
+   void (*exit) (task_t* task);
+   // a tarefa corrente terminou a sua vez (task_yield/task_exit)
+   void (*turn_end) ();
+   // escolhe e retira do indice a proxima tarefa (NULL se nao houver)
+   task_t* (*pick) ();
+   // 1 se a tarefa pronta deve tomar o processador da tarefa corrente
+   int (*preempts) (task_t* task);
+   // o processador vai passar da tarefa prev para a tarefa next
+   void (*switch_to) (task_t* prev, task_t* next);
+   // quantum da tarefa em ms, ou 0 para o quantum padrao (para a
+   // preempcao por tempo)
+   int (*quantum) (task_t* task);
+} sched_ops_t;
+
+extern const sched_ops_t sched_fifo;	// ordem de readyQueue (ppos-core-aux.c)
+extern const sched_ops_t sched_prio;	// ppos-sched.c
+extern const sched_ops_t sched_srtf;	// ppos-sched-srtf.c
+extern const sched_ops_t sched_cfs;	// ppos-sched-cfs.c
+extern const sched_ops_t sched_mlfq;	// ppos-sched-mlfq.c
+extern const sched_ops_t sched_stride;	// ppos-sched-stride.c
+
+extern const sched_ops_t* cpuSched;	// politica em uso
+
+// 1 se as politicas devem imprimir o seu relatorio de cada tarefa no
+// task_exit (variavel de ambiente PPOS_SCHED_REPORT=1 no ppos_init)
+extern int schedReport;
 
 #endif
\ No newline at end of file
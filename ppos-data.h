@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include <ucontext.h>		// biblioteca POSIX de trocas de contexto
 #include "queue.h"		// biblioteca de filas genéricas
+#include "heap.h"		// heap de minimo generico
 
 // Estrutura que define um Task Control Block (TCB)
 typedef struct task_t
@@ -19,6 +20,9 @@ typedef struct task_t
    ucontext_t context ;			// contexto armazenado da tarefa
    unsigned char state;  // indica o estado de uma tarefa (ver defines no final do arquivo ppos.h): 
                           // n - nova, r - pronta, x - executando, s - suspensa, e - terminada
+   int running_time;     // tempo de processador usado (ms), atualizado a cada tick;
+                          // ocupa o espaco de alinhamento apos state, sem mudar o
+                          // tamanho nem os deslocamentos vistos pelo nucleo
    struct task_t* queue;
    struct task_t* joinQueue;
    int exitCode;
@@ -31,6 +35,100 @@ typedef struct task_t
 
 } task_t ;
 
+// Extensao da TCB, mantida fora de task_t: o nucleo (ppos-all.o) foi
+// compilado com o tamanho atual de task_t e guarda os descritores de main
+// e do dispatcher em areas proprias desse tamanho, entao campos novos em
+// task_t seriam escritos por cima de outras variaveis do nucleo.
+// Acessada em O(1) por task_ext() (ppos-core-globals.h).
+struct future_t ;
+struct task_group_t ;
+
+// no de uma tarefa pronta nas filas do escalonador (ver ppos-sched.c)
+typedef struct schednode_t
+{
+   struct schednode_t *prev, *next ;	// ponteiros para usar em filas
+   struct task_t *task ;		// tarefa dona do no
+   long key ;				// nivel absoluto (ver ppos-sched.c)
+   unsigned long seq ;			// ordem de chegada (desempate)
+   heapnode_t heap ;			// no no heap (SRTF, STRIDE, EDF)
+   struct schednode_t *left, *right, *parent ;	// arvore do CFS
+   int red ;				// cor do no na arvore do CFS
+   unsigned long long vruntime ;	// tempo virtual do CFS (ns ponderados)
+   int level ;				// nivel da MLFQ
+   unsigned long long used ;		// processador usado no nivel (MLFQ, ns)
+   unsigned long boost ;		// ultimo reforco visto pelo no (MLFQ)
+   unsigned long long pass ;		// passo do stride
+   long long remain ;			// passo alem do global ao sair (stride)
+   int tickets ;			// bilhetes contabilizados (stride)
+   int active ;				// 1 se disputa o processador (stride)
+   unsigned long long cpu ;		// processador usado (stride, ns)
+   unsigned long long entitled ;	// processador pedido (stride, ns)
+   unsigned long long competed ;	// tempo disputando o processador (ns)
+   unsigned long long passMark ;	// passo global na ultima conta (stride)
+   unsigned long long timeMark ;	// tempo total na ultima conta (stride)
+   int queued ;				// 1 se a tarefa esta no escalonador
+} schednode_t ;
+
+// no de um temporizador na roda de tempo (ver ppos-wheel.c)
+typedef struct wheelnode_t
+{
+   struct wheelnode_t *prev, *next ;	// ponteiros para usar em filas
+   unsigned int expires ;		// instante de expiracao (systime)
+   int slot ;				// 0 se desarmado; senao 1 + lista na roda
+   void (*expire) (struct wheelnode_t *node) ;	// chamada na expiracao
+   void *arg ;				// dado de quem armou o no
+} wheelnode_t ;
+
+// temporizador de software (ver ppos-timer.c)
+typedef struct swtimer_t
+{
+   wheelnode_t node ;			// no na roda de tempo
+   void (*func) (void *arg) ;		// chamada a cada expiracao
+   void *arg ;				// argumento de func
+   unsigned int period ;		// periodo (ms), ou 0 se disparo unico
+   unsigned int fired ;			// expiracoes tratadas
+   unsigned int overruns ;		// periodos perdidos por atraso
+} swtimer_t ;
+
+#define PPOS_TLS_SLOTS 16		// chaves de armazenamento local de tarefa
+
+typedef struct taskext_t
+{
+   void *stack ;			// pilha obtida do pool (ppos-stack.h)
+   size_t stackSize ;			// tamanho utilizavel dessa pilha
+   char *name ;				// nome da tarefa (task_attr_t), ou NULL
+   int prio ;				// prioridade estatica (-20 a +20)
+   int eet ;				// tempo de execucao estimado (SRTF)
+   int tickets ;			// bilhetes (stride)
+   unsigned long long rtPeriod ;	// periodo de tempo real (ns, 0 = comum)
+   unsigned long long rtBudget ;	// processador por trabalho (ns)
+   unsigned long long rtDeadline ;	// prazo relativo (ns)
+   unsigned long long rtRelease ;	// liberacao do trabalho corrente
+   unsigned long long rtAbsDeadline ;	// prazo absoluto do trabalho corrente
+   unsigned int rtJobs ;		// trabalhos concluidos
+   unsigned int rtMisses ;		// trabalhos concluidos apos o prazo
+   void *tls[PPOS_TLS_SLOTS] ;		// valores locais da tarefa, por chave
+   struct future_t *futures ;		// futuros concluidos no termino da tarefa
+   struct task_group_t *group ;		// grupo da tarefa, ou NULL
+   unsigned int createTime ;		// instante de criacao (systime)
+   unsigned int cpuTime ;		// tempo de processador acumulado (ms)
+   unsigned long long cpuNs ;		// o mesmo tempo, em ns
+   unsigned int activations ;		// numero de ativacoes
+   unsigned long long lastActivation ;	// instante da ativacao (systime_ns)
+   schednode_t sched ;			// no nas filas do escalonador
+   wheelnode_t sleep ;			// despertar de task_sleep, ou prazo de
+					// uma espera (ppos-timed.c), na roda de tempo
+} taskext_t ;
+
+// Atributos opcionais de criacao de uma tarefa (ver task_create_attr)
+typedef struct
+{
+   size_t stackSize ;			// tamanho da pilha em bytes (0 = STACKSIZE)
+   int prio ;				// prioridade estatica inicial (-20 a +20)
+   const char *name ;			// nome da tarefa (e copiado), ou NULL
+   struct task_group_t *group ;		// grupo ao qual a tarefa pertence, ou NULL
+} task_attr_t ;
+
 // estrutura que define um semáforo
 typedef struct {
     struct task_t *queue;
@@ -56,6 +154,37 @@ typedef struct {
     mutex_t mutex;
 } barrier_t ;
 
+// estrutura que define um futuro: resultado de uma operacao (termino de
+// tarefa, transferencia de disco...) que pode ser aguardado por tarefas
+typedef struct future_t {
+    struct futurewait_t *waiters;	// fila de tarefas aguardando o futuro
+    struct future_t *nextBound;		// proximo futuro ligado a mesma tarefa
+    int result;
+
+    unsigned char done;
+} future_t ;
+
+// registro de espera de uma tarefa em um futuro (fica na pilha de quem espera)
+typedef struct futurewait_t {
+    struct futurewait_t *prev, *next;	// ponteiros para usar em filas
+    struct task_t *task;		// tarefa que aguarda
+    struct task_t **parked;		// fila onde ela esta suspensa
+} futurewait_t ;
+
+// estrutura que define um grupo de tarefas: os membros sao contados na
+// criacao e no termino, e o ultimo a terminar acorda quem aguarda o grupo
+typedef struct task_group_t {
+    struct task_t *queue;		// tarefas aguardando em group_join
+    int members;			// membros criados no grupo
+    int running;			// membros ainda nao encerrados
+    int failed;				// membros encerrados com codigo nao nulo
+    int status;				// primeiro codigo nao nulo (0 se nenhum)
+    unsigned int cpuTime;		// tempo de processador dos membros encerrados
+    unsigned int activations;		// ativacoes dos membros encerrados
+
+    unsigned char active;
+} task_group_t ;
+
 // estrutura que define uma fila de mensagens
 typedef struct {
     void* content;
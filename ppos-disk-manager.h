@@ -7,6 +7,7 @@
 #ifndef __DISK_MGR__
 #define __DISK_MGR__
 #include "ppos-data.h" 
+#include "cqueue.h"
 
 #define DISK_SCHED_FCFS  0
 #define DISK_SCHED_SSTF  1
@@ -24,9 +25,12 @@ typedef struct diskrequest_t {
     struct diskrequest_t* prev;
 
     task_t* task;
+    future_t* future;        // concluido com 0 ao fim da transferencia
     unsigned char operation; // DISK_REQUEST_READ ou DISK_REQUEST_WRITE
     int block;
     void* buffer;
+    heapnode_t heap;         // no nos heaps do SSTF e do C-SCAN
+    unsigned long seq;       // ordem de chegada (desempate nos heaps)
 } diskrequest_t;
 
 // estrutura que representa um disco no sistema operacional
@@ -35,8 +39,11 @@ typedef struct {
     int numBlocks;
     int blockSize;
     semaphore_t semaforo;
-    unsigned char livre;
-    diskrequest_t* requestQueue;
+    volatile unsigned char livre;  // alterado pelo tratador de SIGUSR1
+    cqueue_t requestQueue;         // pedidos pendentes (diskrequest_t)
+    heap_t ahead;                  // pedidos a frente da cabeca (SSTF, C-SCAN)
+    heap_t behind;                 // pedidos atras da cabeca (SSTF, C-SCAN)
+    unsigned long arrivals;        // contador de pedidos
     semaphore_t work_semaphore;
     int head_pos;          
     int scheduling_policy; 
@@ -54,6 +61,11 @@ int disk_block_read (int block, void *buffer) ;
 // escrita de um bloco, do buffer para o disco
 int disk_block_write (int block, void *buffer) ;
 
+// versoes assincronas: apenas enfileiram o pedido e retornam; o futuro f
+// (ja criado) e concluido com 0 quando a transferencia termina
+int disk_block_read_async (int block, void *buffer, future_t *f) ;
+int disk_block_write_async (int block, void *buffer, future_t *f) ;
+
 // escalonador de requisições do disco
 diskrequest_t* disk_scheduler();
 
@@ -0,0 +1,153 @@
+// PingPongOS - PingPong Operating System
+
+// Futuros: resultado de uma operacao que pode ser aguardado por tarefas.
+//
+// Quem aguarda registra um futurewait_t (na propria pilha) na fila de
+// espera de cada futuro ainda pendente e se suspende em uma fila privada.
+// future_complete acorda cada tarefa registrada que ainda estiver nessa
+// fila privada; ao acordar, a tarefa reavalia a condicao (algum/todos) e
+// retira seus registros antes de retornar. Assim uma tarefa pode aguardar
+// varios futuros ao mesmo tempo, embora so possa estar em uma fila.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+#include "ppos-core-globals.h"
+
+int future_create (future_t *f)
+{
+   if (!f)
+      return (-1) ;
+   f->waiters = NULL ;
+   f->nextBound = NULL ;
+   f->result = 0 ;
+   f->done = 0 ;
+   return (0) ;
+}
+
+int future_complete (future_t *f, int result)
+{
+   futurewait_t *w ;
+   unsigned char old ;
+
+   if (!f || f->done)
+      return (-1) ;
+
+   // tambem chamada por task_exit, ja sem preempcao
+   old = preempt_save () ;
+   f->result = result ;
+   f->done = 1 ;
+
+   // acorda quem ainda dorme; os registros sao removidos pelas proprias tarefas
+   if ((w = f->waiters))
+      do {
+         if (w->task->queue == (task_t *) w->parked)
+            task_resume (w->task) ;
+         w = w->next ;
+      } while (w != f->waiters) ;
+   preempt_restore (old) ;
+   return (0) ;
+}
+
+int future_task (future_t *f, task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+
+   if (!f || !task)
+      return (-1) ;
+
+   // tarefa ja encerrada: o codigo de saida continua no descritor
+   if (!ext)
+      return (task->state == 'x' ? future_complete (f, task->exitCode) : -1) ;
+
+   f->nextBound = ext->futures ;
+   ext->futures = f ;
+   return (0) ;
+}
+
+// conclui os futuros ligados a tarefa corrente, que esta terminando
+void future_task_exit ()
+{
+   taskext_t *ext = task_ext (taskExec) ;
+   future_t *f ;
+
+   while (ext && (f = ext->futures)) {
+      ext->futures = f->nextBound ;
+      f->nextBound = NULL ;
+      future_complete (f, taskExec->exitCode) ;
+   }
+}
+
+int future_done (future_t *f)
+{
+   return (f && f->done) ;
+}
+
+// aguarda ate que todos (all) ou algum dos n futuros esteja concluido;
+// retorna o indice do primeiro concluido encontrado, ou -1 se f for invalido
+static int future_wait (future_t **f, int n, int all)
+{
+   futurewait_t wait[n] ;
+   task_t *parked = NULL ;
+   int i, done, first ;
+   unsigned char old ;
+
+   if (!f || n <= 0)
+      return (-1) ;
+   for (i = 0; i < n; i++) {
+      if (!f[i])
+         return (-1) ;
+      wait[i].task = NULL ;
+   }
+
+   // a cada volta a preempcao e desligada e volta ao estado da chamada
+   old = preemption ;
+   while (1) {
+      PPOS_PREEMPT_DISABLE
+      done = 0 ;
+      first = -1 ;
+      for (i = 0; i < n; i++)
+         if (f[i]->done) {
+            done++ ;
+            if (first < 0)
+               first = i ;
+         }
+      if (all ? done == n : done > 0)
+         break ;
+
+      // registra-se nos futuros pendentes e dorme ate algum concluir
+      for (i = 0; i < n; i++)
+         if (!f[i]->done && !wait[i].task) {
+            wait[i].prev = wait[i].next = NULL ;
+            wait[i].task = taskExec ;
+            wait[i].parked = &parked ;
+            queue_append ((queue_t **) &f[i]->waiters, (queue_t *) &wait[i]) ;
+         }
+      task_suspend (taskExec, &parked) ;
+      preempt_restore (old) ;
+      task_yield () ;
+   }
+
+   for (i = 0; i < n; i++)
+      if (wait[i].task)
+         queue_remove ((queue_t **) &f[i]->waiters, (queue_t *) &wait[i]) ;
+   preempt_restore (old) ;
+   return (first) ;
+}
+
+int future_await (future_t *f)
+{
+   if (future_wait (&f, 1, 1) < 0)
+      return (-1) ;
+   return (f->result) ;
+}
+
+int future_await_any (future_t **f, int n)
+{
+   return (future_wait (f, n, 0)) ;
+}
+
+int future_await_all (future_t **f, int n)
+{
+   return (future_wait (f, n, 1) < 0 ? -1 : 0) ;
+}
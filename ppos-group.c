@@ -0,0 +1,91 @@
+// PingPongOS - PingPong Operating System
+
+// Grupos de tarefas: aguarda o termino de um conjunto de tarefas de uma vez.
+//
+// O grupo so conta os membros (criados em group_task_create, encerrados em
+// group_task_exit); nao ha lista de membros. Quem chama group_join se
+// suspende na fila do grupo e so e acordado pelo termino do ultimo membro,
+// entao a espera custa uma unica suspensao, qualquer que seja o tamanho do
+// grupo. O codigo de saida e o tempo de processador de cada membro sao
+// somados ao grupo no seu termino.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+#include "ppos-core-globals.h"
+
+int group_create (task_group_t *g)
+{
+   if (!g)
+      return (-1) ;
+   g->queue = NULL ;
+   g->members = 0 ;
+   g->running = 0 ;
+   g->failed = 0 ;
+   g->status = 0 ;
+   g->cpuTime = 0 ;
+   g->activations = 0 ;
+   g->active = 1 ;
+   return (0) ;
+}
+
+int group_task_create (task_group_t *g, task_t *task,
+                       void (*start_func)(void *), void *arg)
+{
+   task_attr_t attr ;
+
+   if (!g || !g->active)
+      return (-1) ;
+   task_attr_init (&attr) ;
+   attr.group = g ;
+   return (task_create_attr (task, start_func, arg, &attr)) ;
+}
+
+// contabiliza o termino da tarefa corrente no seu grupo; o ultimo membro
+// acorda quem aguarda o grupo (executada em task_exit, sem preempcao)
+void group_task_exit ()
+{
+   taskext_t *ext = task_ext (taskExec) ;
+   task_group_t *g = ext ? ext->group : NULL ;
+
+   if (!g)
+      return ;
+   ext->group = NULL ;
+
+   g->running-- ;
+   g->cpuTime += (ext->cpuNs + systime_ns () - ext->lastActivation) / 1000000 ;
+   g->activations += ext->activations ;
+   if (taskExec->exitCode && !g->failed++)
+      g->status = taskExec->exitCode ;
+
+   if (g->running == 0)
+      while (g->queue)
+         task_resume (g->queue) ;
+}
+
+int group_join (task_group_t *g)
+{
+   taskext_t *ext = task_ext (taskExec) ;
+   unsigned char old ;
+
+   // um membro esperando pelo proprio grupo nunca seria acordado
+   if (!g || !g->active || (ext && ext->group == g))
+      return (-1) ;
+
+   old = preempt_save () ;
+   if (g->running > 0) {
+      task_suspend (taskExec, &g->queue) ;
+      preempt_restore (old) ;
+      task_yield () ;
+   }
+   preempt_restore (old) ;
+   return (g->status) ;
+}
+
+int group_destroy (task_group_t *g)
+{
+   if (!g || !g->active || g->running > 0)
+      return (-1) ;
+   g->active = 0 ;
+   return (0) ;
+}
@@ -0,0 +1,394 @@
+// PingPongOS - PingPong Operating System
+
+// Escalonador justo (PPOS_SCHED_CFS), no estilo do CFS do Linux: cada
+// tarefa acumula tempo virtual (vruntime), o tempo de processador que
+// consumiu ponderado pelo peso da sua prioridade (task_setprio), e executa
+// primeiro a tarefa pronta com o menor tempo virtual.
+//
+// As tarefas prontas ficam em uma arvore rubro-negra ordenada por vruntime,
+// mantida em paralelo a readyQueue como em ppos-sched.c, com o no mais a
+// esquerda guardado a parte: escolher custa O(1) e inserir/retirar O(log n).
+// O tempo e medido em ns com systime_ns(), pois systime() so tem resolucao
+// de milissegundos.
+//
+// Tarefas novas comecam no menor vruntime do sistema (minVruntime); tarefas
+// que voltam de uma espera (sleepQueue, semaforo...) recebem um credito
+// limitado a CFS_CREDIT abaixo dele, para responderem logo sem acumular
+// vantagem pelo tempo em que estiveram bloqueadas.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+#include "ppos-core-globals.h"
+
+#define CFS_NICE0   1024		// peso da prioridade 0
+#define CFS_CREDIT  3000000ULL		// credito maximo ao acordar (ns)
+#define CFS_GRAN    1000000ULL		// vantagem minima para preempcao (ns)
+
+// pesos das prioridades -20 a +20 (cada nivel ~1.25 vezes o seguinte)
+static const unsigned int weight[41] = {
+   88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+    9548,  7620,  6100,  4904,  3906,  3121,  2501,  1991,  1586,  1277,
+    1024,   820,   655,   526,   423,   335,   272,   215,   172,   137,
+     110,    87,    70,    56,    45,    36,    29,    23,    18,    15,
+      12
+} ;
+
+static schednode_t *root = NULL ;	// arvore das tarefas prontas
+static schednode_t *first = NULL ;	// no de menor vruntime
+static unsigned long long minVruntime = 0 ;	// cresce monotonicamente
+static unsigned long long runStart = 0 ;	// inicio da ativacao corrente
+static unsigned long arrivals = 0 ;	// contador de chegadas
+
+// tempo virtual correspondente a ns de processador para a tarefa
+static unsigned long long cfs_scale (taskext_t *ext, unsigned long long ns)
+{
+   return (ns * CFS_NICE0 / weight[ext->prio + 20]) ;
+}
+
+// 1 se o no a vem antes do no b na arvore
+static int node_before (schednode_t *a, schednode_t *b)
+{
+   if (a->vruntime != b->vruntime)
+      return (a->vruntime < b->vruntime) ;
+   return (a->seq < b->seq) ;
+}
+
+// arvore rubro-negra (Cormen et al.), com NULL como folha preta ==============
+
+static void rotate_left (schednode_t *x)
+{
+   schednode_t *y = x->right ;
+
+   x->right = y->left ;
+   if (y->left)
+      y->left->parent = x ;
+   y->parent = x->parent ;
+   if (!x->parent)
+      root = y ;
+   else if (x == x->parent->left)
+      x->parent->left = y ;
+   else
+      x->parent->right = y ;
+   y->left = x ;
+   x->parent = y ;
+}
+
+static void rotate_right (schednode_t *x)
+{
+   schednode_t *y = x->left ;
+
+   x->left = y->right ;
+   if (y->right)
+      y->right->parent = x ;
+   y->parent = x->parent ;
+   if (!x->parent)
+      root = y ;
+   else if (x == x->parent->right)
+      x->parent->right = y ;
+   else
+      x->parent->left = y ;
+   y->right = x ;
+   x->parent = y ;
+}
+
+static void rb_insert (schednode_t *node)
+{
+   schednode_t **link = &root, *parent = NULL, *p, *g, *u ;
+   int leftmost = 1 ;
+
+   while (*link) {
+      parent = *link ;
+      if (node_before (node, parent))
+         link = &parent->left ;
+      else {
+         link = &parent->right ;
+         leftmost = 0 ;
+      }
+   }
+   node->parent = parent ;
+   node->left = node->right = NULL ;
+   node->red = 1 ;
+   *link = node ;
+   if (leftmost)
+      first = node ;
+
+   // reequilibra: nenhum no vermelho pode ter filho vermelho
+   while ((p = node->parent) && p->red) {
+      g = p->parent ;
+      if (p == g->left) {
+         u = g->right ;
+         if (u && u->red) {
+            p->red = u->red = 0 ;
+            g->red = 1 ;
+            node = g ;
+            continue ;
+         }
+         if (node == p->right) {
+            rotate_left (p) ;
+            node = p ;
+            p = node->parent ;
+         }
+         p->red = 0 ;
+         g->red = 1 ;
+         rotate_right (g) ;
+      }
+      else {
+         u = g->left ;
+         if (u && u->red) {
+            p->red = u->red = 0 ;
+            g->red = 1 ;
+            node = g ;
+            continue ;
+         }
+         if (node == p->left) {
+            rotate_right (p) ;
+            node = p ;
+            p = node->parent ;
+         }
+         p->red = 0 ;
+         g->red = 1 ;
+         rotate_left (g) ;
+      }
+   }
+   root->red = 0 ;
+}
+
+// coloca v (ou NULL) no lugar de u
+static void transplant (schednode_t *u, schednode_t *v)
+{
+   if (!u->parent)
+      root = v ;
+   else if (u == u->parent->left)
+      u->parent->left = v ;
+   else
+      u->parent->right = v ;
+   if (v)
+      v->parent = u->parent ;
+}
+
+static schednode_t *rb_min (schednode_t *node)
+{
+   while (node->left)
+      node = node->left ;
+   return (node) ;
+}
+
+static void rb_erase (schednode_t *z)
+{
+   schednode_t *y = z, *x, *xp, *w ;
+   int yred = z->red ;
+
+   // o sucessor do menor no e o menor da sua subarvore direita ou o pai
+   if (first == z)
+      first = z->right ? rb_min (z->right) : z->parent ;
+
+   if (!z->left) {
+      x = z->right ;
+      xp = z->parent ;
+      transplant (z, z->right) ;
+   }
+   else if (!z->right) {
+      x = z->left ;
+      xp = z->parent ;
+      transplant (z, z->left) ;
+   }
+   else {
+      y = rb_min (z->right) ;
+      yred = y->red ;
+      x = y->right ;
+      if (y->parent == z)
+         xp = y ;
+      else {
+         xp = y->parent ;
+         transplant (y, y->right) ;
+         y->right = z->right ;
+         y->right->parent = y ;
+      }
+      transplant (z, y) ;
+      y->left = z->left ;
+      y->left->parent = y ;
+      y->red = z->red ;
+   }
+   if (yred)
+      return ;
+
+   // um no preto saiu do caminho de x: reequilibra
+   while (x != root && (!x || !x->red)) {
+      if (x == xp->left) {
+         w = xp->right ;
+         if (w->red) {
+            w->red = 0 ;
+            xp->red = 1 ;
+            rotate_left (xp) ;
+            w = xp->right ;
+         }
+         if ((!w->left || !w->left->red) && (!w->right || !w->right->red)) {
+            w->red = 1 ;
+            x = xp ;
+            xp = x->parent ;
+            continue ;
+         }
+         if (!w->right || !w->right->red) {
+            w->left->red = 0 ;
+            w->red = 1 ;
+            rotate_right (w) ;
+            w = xp->right ;
+         }
+         w->red = xp->red ;
+         xp->red = 0 ;
+         if (w->right)
+            w->right->red = 0 ;
+         rotate_left (xp) ;
+      }
+      else {
+         w = xp->left ;
+         if (w->red) {
+            w->red = 0 ;
+            xp->red = 1 ;
+            rotate_right (xp) ;
+            w = xp->left ;
+         }
+         if ((!w->left || !w->left->red) && (!w->right || !w->right->red)) {
+            w->red = 1 ;
+            x = xp ;
+            xp = x->parent ;
+            continue ;
+         }
+         if (!w->left || !w->left->red) {
+            w->right->red = 0 ;
+            w->red = 1 ;
+            rotate_left (w) ;
+            w = xp->left ;
+         }
+         w->red = xp->red ;
+         xp->red = 0 ;
+         if (w->left)
+            w->left->red = 0 ;
+         rotate_right (xp) ;
+      }
+      x = root ;
+   }
+   if (x)
+      x->red = 0 ;
+}
+
+// interface do escalonador ====================================================
+
+// soma ao vruntime da tarefa corrente o processador usado desde runStart
+static void cfs_charge (taskext_t *ext)
+{
+   unsigned long long now = systime_ns () ;
+
+   if (runStart)
+      ext->sched.vruntime += cfs_scale (ext, now - runStart) ;
+   runStart = now ;
+}
+
+static void cfs_enqueue (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+   schednode_t *node ;
+
+   if (!ext || ext->sched.queued)
+      return ;
+   node = &ext->sched ;
+   if (task == taskExec)
+      cfs_charge (ext) ;		// cedeu o processador (task_yield)
+   else if (!node->seq)
+      node->vruntime = minVruntime ;	// tarefa nova
+   else if (node->vruntime + CFS_CREDIT < minVruntime)
+      node->vruntime = minVruntime - CFS_CREDIT ;	// voltou de uma espera
+   node->task = task ;
+   node->seq = ++arrivals ;
+   node->queued = 1 ;
+   rb_insert (node) ;
+}
+
+static void cfs_dequeue (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+
+   if (!ext || !ext->sched.queued)
+      return ;
+   rb_erase (&ext->sched) ;
+   ext->sched.queued = 0 ;
+}
+
+static void cfs_exit (task_t *task)
+{
+}
+
+// o CFS nao conta vezes, e sim tempo
+static void cfs_turn_end ()
+{
+}
+
+static task_t *cfs_pick ()
+{
+   schednode_t *node = first ;
+
+   if (!node)
+      return (NULL) ;
+   rb_erase (node) ;
+   node->queued = 0 ;
+   return (node->task) ;
+}
+
+// uma tarefa pronta bem atras da corrente em tempo virtual toma o processador
+static int cfs_preempts (task_t *task)
+{
+   taskext_t *ext = task_ext (task), *cur = task_ext (taskExec) ;
+   unsigned long long curVruntime ;
+
+   if (!ext || !ext->sched.queued || !cur)
+      return (0) ;
+   curVruntime = cur->sched.vruntime + cfs_scale (cur, systime_ns () - runStart) ;
+   return (ext->sched.vruntime + CFS_GRAN < curVruntime) ;
+}
+
+static void cfs_switch (task_t *prev, task_t *next)
+{
+   taskext_t *ext = task_ext (prev) ;
+   unsigned long long low ;
+
+   // quem cedeu o processador ja foi contabilizado ao entrar na arvore
+   if (ext && prev != taskDisp && !ext->sched.queued)
+      cfs_charge (ext) ;
+   runStart = systime_ns () ;
+
+   // minVruntime acompanha a menor tarefa entre a proxima e as prontas
+   ext = (next != taskDisp) ? task_ext (next) : NULL ;
+   if (ext)
+      low = ext->sched.vruntime ;
+   else if (first)
+      low = first->vruntime ;
+   else
+      return ;
+   if (first && first->vruntime < low)
+      low = first->vruntime ;
+   if (low > minVruntime)
+      minVruntime = low ;
+}
+
+static void cfs_init ()
+{
+}
+
+static int cfs_quantum (task_t *task)
+{
+   return (0) ;
+}
+
+const sched_ops_t sched_cfs = {
+   .name      = "CFS",
+   .init      = cfs_init,
+   .enqueue   = cfs_enqueue,
+   .dequeue   = cfs_dequeue,
+   .exit      = cfs_exit,
+   .turn_end  = cfs_turn_end,
+   .pick      = cfs_pick,
+   .preempts  = cfs_preempts,
+   .switch_to = cfs_switch,
+   .quantum   = cfs_quantum
+} ;
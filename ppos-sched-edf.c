@@ -0,0 +1,307 @@
+// PingPongOS - PingPong Operating System
+
+// Classe de tempo real EDF (earliest deadline first), acima da politica de
+// escalonamento em uso: tarefas periodicas (task_set_rt) executam antes das
+// demais, em ordem de prazo absoluto; as tarefas comuns continuam com a
+// politica escolhida em PPOS_CPU_SCHED.
+//
+// A classe e instalada na primeira admissao de uma tarefa periodica: passa
+// a ser cpuSched e repassa a politica anterior (base) tudo o que se refere
+// as tarefas comuns, entao um sistema sem tarefas periodicas nao paga nada
+// por ela.
+//
+// Cada periodo libera um trabalho com prazo absoluto igual a liberacao mais
+// o prazo relativo. As tarefas periodicas prontas ficam em um heap de
+// minimo pelo prazo absoluto, sobre o no do escalonador (ext->sched), que a
+// politica base nao usa para elas. Em task_rt_wait a tarefa se suspende ate
+// a proxima liberacao, com um despertar na roda de tempo (ext->sleep, como
+// task_sleep), entao so ha tarefas periodicas prontas com o trabalho ja
+// liberado, e o dispatcher fica ocioso se nada mais houver. O tempo e
+// medido em ns com systime_ns(), como no CFS.
+//
+// Admissao: a soma das densidades orcamento / min (prazo, periodo) das
+// tarefas periodicas nao pode passar de PPOS_RT_CAPACITY por cento, o que
+// garante os prazos pelo EDF enquanto cada trabalho respeitar o orcamento
+// declarado. O orcamento e o quantum de cada ativacao, mas o trabalho
+// preemptado volta ao heap com o mesmo prazo, entao o orcamento do trabalho
+// inteiro nao e imposto; um trabalho concluido apos o prazo e contado em
+// rtMisses (task_rt_misses, e no task_exit com PPOS_SCHED_REPORT=1).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+#include "ppos-core-globals.h"
+#include "ppos-wheel.h"
+
+#define MS 1000000ULL			// ns por ms
+#define RT_PPM 1000000ULL		// utilizacao em partes por milhao
+
+static int node_before (heapnode_t *a, heapnode_t *b) ;
+
+static const sched_ops_t *base = NULL ;	// politica das tarefas comuns
+static heap_t ready = HEAP_INIT (node_before) ;	// trabalhos liberados
+static unsigned long long utilization = 0 ;	// densidade admitida (ppm)
+static unsigned long arrivals = 0 ;	// contador de chegadas
+
+// densidade de uma tarefa periodica (ppm)
+static unsigned long long edf_density (taskext_t *ext)
+{
+   unsigned long long window = ext->rtDeadline < ext->rtPeriod ?
+                               ext->rtDeadline : ext->rtPeriod ;
+
+   return (ext->rtBudget * RT_PPM / window) ;
+}
+
+// heap de minimo por node->key ===============================================
+
+// 1 se o no a deve sair antes do no b
+static int node_before (heapnode_t *a, heapnode_t *b)
+{
+   schednode_t *x = heap_entry (a, schednode_t, heap) ;
+   schednode_t *y = heap_entry (b, schednode_t, heap) ;
+
+   if (x->key != y->key)
+      return (x->key < y->key) ;
+   return (x->seq < y->seq) ;
+}
+
+// no do topo do heap, ou NULL se ele estiver vazio
+static schednode_t *edf_first (heap_t *h)
+{
+   heapnode_t *first = heap_first (h) ;
+
+   return (first ? heap_entry (first, schednode_t, heap) : NULL) ;
+}
+
+static int edf_insert (heap_t *h, schednode_t *node)
+{
+   if (heap_insert (h, &node->heap) < 0) {
+      perror ("Erro ao alocar o heap da classe EDF") ;
+      return (-1) ;
+   }
+   return (0) ;
+}
+
+// interface do escalonador ====================================================
+
+// tarefa periodica ainda nao encerrada
+static taskext_t *edf_ext (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+
+   return ((ext && ext->rtPeriod) ? ext : NULL) ;
+}
+
+static void edf_init ()
+{
+   base->init () ;
+}
+
+static void edf_enqueue (task_t *task)
+{
+   taskext_t *ext = edf_ext (task) ;
+   schednode_t *node ;
+
+   if (!ext) {
+      base->enqueue (task) ;
+      return ;
+   }
+   node = &ext->sched ;
+   if (node->queued)
+      return ;
+   node->task = task ;
+   node->seq = ++arrivals ;
+   node->key = ext->rtAbsDeadline ;
+   if (edf_insert (&ready, node) == 0)
+      node->queued = 1 ;
+}
+
+static void edf_dequeue (task_t *task)
+{
+   taskext_t *ext = edf_ext (task) ;
+
+   if (!ext) {
+      base->dequeue (task) ;
+      return ;
+   }
+   if (!ext->sched.queued)
+      return ;
+   heap_remove (&ready, &ext->sched.heap) ;
+   ext->sched.queued = 0 ;
+}
+
+// a tarefa periodica que termina devolve a sua parte da capacidade e, se
+// pedido, informa os prazos perdidos
+static void edf_exit (task_t *task)
+{
+   taskext_t *ext = edf_ext (task) ;
+
+   if (!ext) {
+      base->exit (task) ;
+      return ;
+   }
+   utilization -= edf_density (ext) ;
+   ext->rtPeriod = 0 ;
+   if (schedReport)
+      printf ("Task %d exit: %u jobs, %u deadline misses\n", task->id,
+              ext->rtJobs, ext->rtMisses) ;
+}
+
+static void edf_turn_end ()
+{
+   base->turn_end () ;
+}
+
+static task_t *edf_pick ()
+{
+   schednode_t *node ;
+
+   if ((node = edf_first (&ready))) {
+      heap_remove (&ready, &node->heap) ;
+      node->queued = 0 ;
+      return (node->task) ;
+   }
+   return (base->pick ()) ;
+}
+
+// trabalhos liberados tomam o processador de tarefas comuns e de trabalhos
+// com prazo mais distante
+static int edf_preempts (task_t *task)
+{
+   taskext_t *ext = edf_ext (task), *cur = edf_ext (taskExec) ;
+
+   if (!ext)
+      return (cur ? 0 : base->preempts (task)) ;
+   if (!ext->sched.queued)
+      return (0) ;
+   return (!cur || ext->rtAbsDeadline < cur->rtAbsDeadline) ;
+}
+
+static void edf_switch (task_t *prev, task_t *next)
+{
+   base->switch_to (prev, next) ;
+}
+
+static int edf_quantum (task_t *task)
+{
+   taskext_t *ext = edf_ext (task) ;
+
+   if (!ext)
+      return (base->quantum (task)) ;
+   return ((int) (ext->rtBudget / MS)) ;
+}
+
+static const sched_ops_t sched_edf = {
+   .name      = "EDF",
+   .init      = edf_init,
+   .enqueue   = edf_enqueue,
+   .dequeue   = edf_dequeue,
+   .exit      = edf_exit,
+   .turn_end  = edf_turn_end,
+   .pick      = edf_pick,
+   .preempts  = edf_preempts,
+   .switch_to = edf_switch,
+   .quantum   = edf_quantum
+} ;
+
+// API de tempo real ===========================================================
+
+int task_set_rt (task_t *task, int period, int budget, int deadline)
+{
+   taskext_t *ext ;
+   unsigned long long old, density ;
+   int queued ;
+
+   if (!task)
+      task = taskExec ;
+   if (!(ext = task_ext (task)) || task == taskDisp)
+      return (-1) ;
+   if (!period && !ext->rtPeriod)
+      return (0) ;
+   if (!deadline)
+      deadline = period ;
+   if (period < 0 || (period && (budget <= 0 || deadline <= 0 || budget > deadline)))
+      return (-1) ;
+
+   // teste de admissao, sem a densidade atual da propria tarefa
+   old = ext->rtPeriod ? edf_density (ext) : 0 ;
+   density = period ? (unsigned long long) budget * RT_PPM /
+                      (deadline < period ? deadline : period) : 0 ;
+   if (utilization - old + density > PPOS_RT_CAPACITY * RT_PPM / 100)
+      return (-1) ;
+
+   PPOS_PREEMPT_DISABLE
+   if (!base) {
+      base = cpuSched ;
+      cpuSched = &sched_edf ;
+   }
+   // a tarefa pronta muda de classe: sai do indice antigo e entra no novo
+   queued = (task->queue == (task_t *) &readyQueue) ;
+   if (queued)
+      edf_dequeue (task) ;
+   utilization += density - old ;
+   ext->rtPeriod = period * MS ;
+   ext->rtBudget = budget * MS ;
+   ext->rtDeadline = deadline * MS ;
+   if (period) {
+      ext->rtRelease = systime_ns () ;
+      ext->rtAbsDeadline = ext->rtRelease + ext->rtDeadline ;
+   }
+   if (queued)
+      edf_enqueue (task) ;
+   PPOS_PREEMPT_ENABLE
+   return (0) ;
+}
+
+// liberacao do proximo trabalho (no dispatcher)
+static void edf_release (wheelnode_t *node)
+{
+   task_resume ((task_t *) node->arg) ;
+}
+
+int task_rt_wait ()
+{
+   taskext_t *ext = edf_ext (taskExec) ;
+   task_t *parked = NULL ;
+   unsigned long long now = systime_ns () ;
+   unsigned int expires ;
+
+   if (!ext)
+      return (-1) ;
+   ext->rtJobs++ ;
+   if (now > ext->rtAbsDeadline)
+      ext->rtMisses++ ;
+
+   // o proximo trabalho e liberado no inicio do proximo periodo; se ele ja
+   // comecou (trabalho atrasado), a tarefa segue sem dormir
+   ext->rtRelease += ext->rtPeriod ;
+   ext->rtAbsDeadline = ext->rtRelease + ext->rtDeadline ;
+   if (now >= ext->rtRelease)
+      return (0) ;
+
+   // dorme ate o ms em que a liberacao ja passou (systime trunca systime_ns)
+   expires = (ext->rtRelease + MS - 1) / MS ;
+   PPOS_PREEMPT_DISABLE
+   ext->sleep.expire = edf_release ;
+   ext->sleep.arg = taskExec ;
+   task_suspend (taskExec, &parked) ;
+   wheel_add (&ext->sleep, expires) ;
+   PPOS_PREEMPT_ENABLE
+   tick_wake (expires) ;
+   task_yield () ;
+   return (0) ;
+}
+
+int task_rt_jobs (task_t *task)
+{
+   taskext_t *ext = task_ext (task ? task : taskExec) ;
+
+   return (ext ? (int) ext->rtJobs : -1) ;
+}
+
+int task_rt_misses (task_t *task)
+{
+   taskext_t *ext = task_ext (task ? task : taskExec) ;
+
+   return (ext ? (int) ext->rtMisses : -1) ;
+}
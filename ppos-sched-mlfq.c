@@ -0,0 +1,276 @@
+// PingPongOS - PingPong Operating System
+
+// Escalonador de filas multinivel com realimentacao (PPOS_SCHED_MLFQ).
+//
+// Ha uma fila FIFO por nivel, mantida em paralelo a readyQueue como em
+// ppos-sched.c, e um mapa de bits dos niveis nao vazios: executa primeiro
+// a tarefa mais antiga do nivel mais alto (0). Cada nivel tem o seu
+// quantum, o dobro do nivel anterior:
+//
+// - uma tarefa nova entra no nivel 0;
+// - o processador usado em um nivel se acumula entre as vezes da tarefa;
+//   ao esgotar o quantum do nivel, ela desce um nivel, onde o quantum e
+//   maior (tarefas de processamento trocam menos de contexto);
+// - uma tarefa que se bloqueia (semaforo, disco, sleep...) antes de
+//   esgotar o quantum sobe um nivel e recomeca a contagem, e volta das
+//   esperas na frente das tarefas de processamento;
+// - a cada reforco (boost) todas as tarefas voltam ao nivel 0, para que
+//   as dos niveis baixos nao fiquem sem processador.
+//
+// O reforco concatena as filas no nivel 0, em O(niveis); cada no guarda o
+// numero do ultimo reforco que viu, e o seu nivel so e corrigido quando
+// volta a ser usado. O tempo e medido com systime_ns(), como no CFS.
+//
+// Configuracao, lida no ppos_init (variaveis de ambiente):
+//   PPOS_MLFQ_LEVELS   numero de niveis (1 a MLFQ_MAXLEVELS, padrao 4)
+//   PPOS_MLFQ_QUANTUM  quantum do nivel 0 em ms (padrao 2)
+//   PPOS_MLFQ_BOOST    intervalo entre reforcos em ms (padrao 500, 0 = nunca)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+#include "ppos-core-globals.h"
+
+#define MLFQ_MAXLEVELS 16
+
+static int levels = 4 ;			// niveis em uso
+static unsigned long long quantum = 2000000ULL ;	// quantum do nivel 0 (ns)
+static unsigned long long boostPeriod = 500000000ULL ;	// entre reforcos (ns)
+
+static schednode_t *level[MLFQ_MAXLEVELS] ;	// filas circulares por nivel
+static unsigned int bitmap = 0 ;	// bit n: nivel n nao vazio
+static unsigned long boosts = 0 ;	// reforcos ja feitos
+static unsigned long long lastBoost = 0 ;	// instante do ultimo reforco
+static unsigned long long runStart = 0 ;	// inicio da ativacao corrente
+static unsigned long arrivals = 0 ;	// contador de chegadas
+
+// quantum do nivel n (ns)
+static unsigned long long level_quantum (int n)
+{
+   return (quantum << n) ;
+}
+
+// insere o no no fim da fila circular *q
+static void node_append (schednode_t **q, schednode_t *node)
+{
+   if (!*q) {
+      node->prev = node->next = node ;
+      *q = node ;
+      return ;
+   }
+   node->prev = (*q)->prev ;
+   node->next = *q ;
+   (*q)->prev->next = node ;
+   (*q)->prev = node ;
+}
+
+// retira o no da fila circular *q
+static void node_remove (schednode_t **q, schednode_t *node)
+{
+   if (node->next == node)
+      *q = NULL ;
+   else {
+      node->prev->next = node->next ;
+      node->next->prev = node->prev ;
+      if (*q == node)
+         *q = node->next ;
+   }
+   node->prev = node->next = NULL ;
+}
+
+// aplica ao no os reforcos feitos desde que ele foi usado pela ultima vez
+static void mlfq_sync (schednode_t *node)
+{
+   if (node->boost == boosts)
+      return ;
+   node->level = 0 ;
+   node->used = 0 ;
+   node->boost = boosts ;
+}
+
+// soma ao nivel da tarefa o processador usado desde runStart; desce um
+// nivel se o quantum do nivel se esgotou (retorna 1 nesse caso)
+static int mlfq_charge (schednode_t *node)
+{
+   unsigned long long now = systime_ns () ;
+
+   mlfq_sync (node) ;
+   if (runStart)
+      node->used += now - runStart ;
+   runStart = now ;
+   if (node->used < level_quantum (node->level))
+      return (0) ;
+   if (node->level < levels - 1)
+      node->level++ ;
+   node->used = 0 ;
+   return (1) ;
+}
+
+// todas as tarefas voltam ao nivel 0, mantendo a ordem entre os niveis
+static void mlfq_boost ()
+{
+   int n ;
+
+   for (n = 1; n < levels; n++) {
+      schednode_t *q = level[n] ;
+      if (!q)
+         continue ;
+      if (level[0]) {
+         schednode_t *last = level[0]->prev ;
+         level[0]->prev = q->prev ;
+         q->prev->next = level[0] ;
+         last->next = q ;
+         q->prev = last ;
+      }
+      else
+         level[0] = q ;
+      level[n] = NULL ;
+   }
+   bitmap = level[0] ? 1 : 0 ;
+   boosts++ ;
+}
+
+static void mlfq_enqueue (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+   schednode_t *node ;
+
+   if (!ext || ext->sched.queued)
+      return ;
+   node = &ext->sched ;
+   if (!node->seq) {
+      node->level = 0 ;			// tarefa nova
+      node->used = 0 ;
+      node->boost = boosts ;
+   }
+   if (task == taskExec)
+      mlfq_charge (node) ;		// cedeu o processador (task_yield)
+   else
+      mlfq_sync (node) ;
+   node->task = task ;
+   node->seq = ++arrivals ;
+   node->queued = 1 ;
+   node_append (&level[node->level], node) ;
+   bitmap |= 1U << node->level ;
+}
+
+static void mlfq_dequeue (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+   schednode_t *node ;
+
+   if (!ext || !ext->sched.queued)
+      return ;
+   node = &ext->sched ;
+   mlfq_sync (node) ;
+   node_remove (&level[node->level], node) ;
+   if (!level[node->level])
+      bitmap &= ~(1U << node->level) ;
+   node->queued = 0 ;
+}
+
+static void mlfq_exit (task_t *task)
+{
+}
+
+// a MLFQ conta o tempo usado em cada nivel, e nao as vezes
+static void mlfq_turn_end ()
+{
+}
+
+static task_t *mlfq_pick ()
+{
+   schednode_t *node ;
+   int n ;
+
+   if (boostPeriod && systime_ns () - lastBoost >= boostPeriod) {
+      mlfq_boost () ;
+      lastBoost = systime_ns () ;
+   }
+   if (!bitmap)
+      return (NULL) ;
+   n = __builtin_ctz (bitmap) ;
+   node = level[n] ;
+   node_remove (&level[n], node) ;
+   if (!level[n])
+      bitmap &= ~(1U << n) ;
+   node->queued = 0 ;
+   return (node->task) ;
+}
+
+// uma tarefa pronta em nivel acima da corrente toma o processador
+static int mlfq_preempts (task_t *task)
+{
+   taskext_t *ext = task_ext (task), *cur = task_ext (taskExec) ;
+
+   if (!ext || !ext->sched.queued || !cur)
+      return (0) ;
+   mlfq_sync (&ext->sched) ;
+   mlfq_sync (&cur->sched) ;
+   return (ext->sched.level < cur->sched.level) ;
+}
+
+static void mlfq_switch (task_t *prev, task_t *next)
+{
+   taskext_t *ext = task_ext (prev) ;
+   schednode_t *node ;
+
+   // quem cedeu o processador ja foi contabilizado ao entrar na fila; quem
+   // se bloqueou antes de esgotar o quantum sobe um nivel
+   if (ext && prev != taskDisp && !ext->sched.queued) {
+      node = &ext->sched ;
+      if (!mlfq_charge (node)) {
+         if (node->level > 0)
+            node->level-- ;
+         node->used = 0 ;
+      }
+   }
+   runStart = systime_ns () ;
+}
+
+// le a configuracao; valores invalidos mantem o padrao
+static void mlfq_init ()
+{
+   char *str ;
+   int value ;
+
+   if ((str = getenv ("PPOS_MLFQ_LEVELS"))) {
+      value = atoi (str) ;
+      if (value >= 1 && value <= MLFQ_MAXLEVELS)
+         levels = value ;
+   }
+   if ((str = getenv ("PPOS_MLFQ_QUANTUM"))) {
+      value = atoi (str) ;
+      if (value > 0)
+         quantum = value * 1000000ULL ;
+   }
+   if ((str = getenv ("PPOS_MLFQ_BOOST"))) {
+      value = atoi (str) ;
+      if (value >= 0)
+         boostPeriod = value * 1000000ULL ;
+   }
+   lastBoost = systime_ns () ;
+}
+
+static int mlfq_quantum (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+
+   if (!ext)
+      return (0) ;
+   mlfq_sync (&ext->sched) ;
+   return ((int) (level_quantum (ext->sched.level) / 1000000ULL)) ;
+}
+
+const sched_ops_t sched_mlfq = {
+   .name      = "MLFQ",
+   .init      = mlfq_init,
+   .enqueue   = mlfq_enqueue,
+   .dequeue   = mlfq_dequeue,
+   .exit      = mlfq_exit,
+   .turn_end  = mlfq_turn_end,
+   .pick      = mlfq_pick,
+   .preempts  = mlfq_preempts,
+   .switch_to = mlfq_switch,
+   .quantum   = mlfq_quantum
+} ;
@@ -0,0 +1,115 @@
+// PingPongOS - PingPong Operating System
+
+// Escalonador SRTF (PPOS_SCHED_SRTF): executa primeiro a tarefa com o menor
+// tempo restante, isto e, tempo estimado (task_set_eet) menos o tempo de
+// processador ja consumido (running_time).
+//
+// As tarefas prontas ficam em um heap de minimo (heap.h), mantido em
+// paralelo a readyQueue como em ppos-sched.c; cada no guarda a sua posicao
+// no heap, entao inserir, retirar do meio e escolher custam O(log n).
+// Uma tarefa pronta nao executa, entao a sua chave nao muda enquanto ela
+// esta no heap. Empates seguem a ordem de chegada.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+#include "ppos-core-globals.h"
+
+static unsigned long arrivals = 0 ;	// contador de chegadas
+
+// 1 se o no a deve sair antes do no b
+static int node_before (heapnode_t *a, heapnode_t *b)
+{
+   schednode_t *x = heap_entry (a, schednode_t, heap) ;
+   schednode_t *y = heap_entry (b, schednode_t, heap) ;
+
+   if (x->key != y->key)
+      return (x->key < y->key) ;
+   return (x->seq < y->seq) ;
+}
+
+static heap_t ready = HEAP_INIT (node_before) ;	// pelo tempo restante
+
+static void srtf_enqueue (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+   schednode_t *node ;
+
+   if (!ext || ext->sched.queued)
+      return ;
+   node = &ext->sched ;
+   node->task = task ;
+   node->key = task_get_ret (task) ;
+   node->seq = arrivals++ ;
+   if (heap_insert (&ready, &node->heap) < 0) {
+      perror ("Erro ao alocar o heap do escalonador SRTF") ;
+      return ;
+   }
+   node->queued = 1 ;
+}
+
+static void srtf_dequeue (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+
+   if (ext && ext->sched.queued) {
+      heap_remove (&ready, &ext->sched.heap) ;
+      ext->sched.queued = 0 ;
+   }
+}
+
+static void srtf_exit (task_t *task)
+{
+}
+
+// o SRTF nao envelhece as tarefas
+static void srtf_turn_end ()
+{
+}
+
+static task_t *srtf_pick ()
+{
+   heapnode_t *first = heap_pop (&ready) ;
+   schednode_t *node ;
+
+   if (!first)
+      return (NULL) ;
+   node = heap_entry (first, schednode_t, heap) ;
+   node->queued = 0 ;
+   return (node->task) ;
+}
+
+// uma tarefa pronta com menos tempo restante toma o processador
+static int srtf_preempts (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+
+   return (ext && ext->sched.queued && ext->sched.key < task_get_ret (taskExec)) ;
+}
+
+// o tempo consumido ja e contabilizado em running_time
+static void srtf_switch (task_t *prev, task_t *next)
+{
+}
+
+static void srtf_init ()
+{
+}
+
+static int srtf_quantum (task_t *task)
+{
+   return (0) ;
+}
+
+const sched_ops_t sched_srtf = {
+   .name      = "SRTF",
+   .init      = srtf_init,
+   .enqueue   = srtf_enqueue,
+   .dequeue   = srtf_dequeue,
+   .exit      = srtf_exit,
+   .turn_end  = srtf_turn_end,
+   .pick      = srtf_pick,
+   .preempts  = srtf_preempts,
+   .switch_to = srtf_switch,
+   .quantum   = srtf_quantum
+} ;
@@ -0,0 +1,229 @@
+// PingPongOS - PingPong Operating System
+
+// Escalonador proporcional por passos (stride scheduling, Waldspurger e
+// Weihl), politica STRIDE: cada tarefa tem bilhetes (task_set_tickets) e
+// recebe o processador na proporcao dos seus bilhetes sobre os de todas as
+// tarefas que o disputam; uma tarefa com 300 bilhetes executa 3 vezes mais
+// que uma com 100.
+//
+// Cada tarefa tem um passo (pass), que avanca STRIDE1 / bilhetes por ns de
+// processador usado, e executa primeiro a tarefa pronta com o menor passo.
+// As tarefas prontas ficam em um heap de minimo pelo passo (heap.h), mantido
+// em paralelo a readyQueue como em ppos-sched-srtf.c. O passo global
+// (globalPass) avanca STRIDE1 / (bilhetes de todas as que disputam) por ns:
+// uma tarefa que chega comeca nele, e uma que se bloqueia guarda a sua
+// distancia a ele (remain) e a recupera ao voltar, sem acumular vantagem
+// pelo tempo bloqueada. O tempo e medido com systime_ns(), como no CFS.
+//
+// Enquanto disputa o processador, a tarefa acumula o tempo usado (cpu), o
+// tempo que lhe caberia pelos bilhetes (entitled) e o tempo que passou
+// disputando (competed); no task_exit, com PPOS_SCHED_REPORT=1, a parcela
+// obtida (cpu / competed) e comparada com a pedida (entitled / competed).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+#include "ppos-core-globals.h"
+
+#define STRIDE1 (1ULL << 16)		// passo por ns de uma tarefa com 1 bilhete
+
+static unsigned long arrivals = 0 ;	// contador de chegadas
+static unsigned long long globalPass = 0 ;	// passo global
+static unsigned long long totalTime = 0 ;	// processador usado por todas (ns)
+static long totalTickets = 0 ;		// bilhetes das tarefas que disputam
+static unsigned long long runStart = 0 ;	// inicio da ativacao corrente
+
+// 1 se o no a deve sair antes do no b
+static int node_before (heapnode_t *a, heapnode_t *b)
+{
+   schednode_t *x = heap_entry (a, schednode_t, heap) ;
+   schednode_t *y = heap_entry (b, schednode_t, heap) ;
+
+   if (x->pass != y->pass)
+      return (x->pass < y->pass) ;
+   return (x->seq < y->seq) ;
+}
+
+static heap_t ready = HEAP_INIT (node_before) ;	// pelo passo
+
+// soma ao no a parte pedida do tempo passado desde a ultima conta
+static void stride_settle (schednode_t *node)
+{
+   node->entitled += node->tickets * (globalPass - node->passMark) / STRIDE1 ;
+   node->competed += totalTime - node->timeMark ;
+   node->passMark = globalPass ;
+   node->timeMark = totalTime ;
+}
+
+// a tarefa passa a disputar o processador
+static void stride_join (schednode_t *node, taskext_t *ext)
+{
+   if (!node->seq) {
+      node->remain = 0 ;		// tarefa nova
+      node->cpu = node->entitled = node->competed = 0 ;
+   }
+   node->tickets = ext->tickets ;
+   node->pass = globalPass ;
+   if (node->remain > 0 || globalPass >= (unsigned long long) -node->remain)
+      node->pass += node->remain ;
+   node->passMark = globalPass ;
+   node->timeMark = totalTime ;
+   node->active = 1 ;
+   totalTickets += node->tickets ;
+}
+
+// a tarefa deixa de disputar o processador (bloqueou ou terminou)
+static void stride_leave (schednode_t *node)
+{
+   stride_settle (node) ;
+   node->remain = (long long) (node->pass - globalPass) ;
+   node->active = 0 ;
+   totalTickets -= node->tickets ;
+}
+
+// aplica uma mudanca de bilhetes (task_set_tickets): a distancia ao passo
+// global e refeita na nova proporcao
+static void stride_tickets (schednode_t *node, taskext_t *ext)
+{
+   long long remain ;
+
+   if (node->tickets == ext->tickets)
+      return ;
+   stride_settle (node) ;
+   remain = (long long) (node->pass - globalPass) ;
+   remain = remain * node->tickets / ext->tickets ;
+   node->pass = globalPass + remain ;
+   totalTickets += ext->tickets - node->tickets ;
+   node->tickets = ext->tickets ;
+}
+
+// avanca os passos pelo processador usado pela tarefa corrente desde runStart
+static void stride_charge (schednode_t *node)
+{
+   unsigned long long now = systime_ns (), used ;
+
+   if (runStart) {
+      used = now - runStart ;
+      node->pass += used * STRIDE1 / node->tickets ;
+      node->cpu += used ;
+      globalPass += used * STRIDE1 / totalTickets ;
+      totalTime += used ;
+   }
+   runStart = now ;
+}
+
+static void stride_enqueue (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+   schednode_t *node ;
+
+   if (!ext || ext->sched.queued)
+      return ;
+   node = &ext->sched ;
+   if (!node->active)
+      stride_join (node, ext) ;
+   else {
+      if (task == taskExec)
+         stride_charge (node) ;		// cedeu o processador (task_yield)
+      stride_tickets (node, ext) ;
+   }
+   node->task = task ;
+   node->seq = ++arrivals ;
+   if (heap_insert (&ready, &node->heap) < 0) {
+      perror ("Erro ao alocar o heap do escalonador STRIDE") ;
+      return ;
+   }
+   node->queued = 1 ;
+}
+
+static void stride_dequeue (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+
+   if (ext && ext->sched.queued) {
+      heap_remove (&ready, &ext->sched.heap) ;
+      ext->sched.queued = 0 ;
+   }
+}
+
+// relatorio da parcela obtida e da pedida pela tarefa, se pedido
+static void stride_exit (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+   schednode_t *node ;
+
+   if (!ext || !ext->sched.active)
+      return ;
+   node = &ext->sched ;
+   stride_charge (node) ;
+   stride_tickets (node, ext) ;
+   stride_leave (node) ;
+   if (!schedReport)
+      return ;
+   printf ("Task %d exit: processor time %4llu ms, share %5.1f%% "
+           "(requested %5.1f%%, %d tickets)\n", task->id, node->cpu / 1000000,
+           node->competed ? 100.0 * node->cpu / node->competed : 0.0,
+           node->competed ? 100.0 * node->entitled / node->competed : 0.0,
+           node->tickets) ;
+}
+
+// o stride nao conta vezes, e sim tempo
+static void stride_turn_end ()
+{
+}
+
+static task_t *stride_pick ()
+{
+   heapnode_t *first = heap_pop (&ready) ;
+   schednode_t *node ;
+
+   if (!first)
+      return (NULL) ;
+   node = heap_entry (first, schednode_t, heap) ;
+   node->queued = 0 ;
+   return (node->task) ;
+}
+
+// as proporcoes so valem nas decisoes do dispatcher
+static int stride_preempts (task_t *task)
+{
+   return (0) ;
+}
+
+static void stride_switch (task_t *prev, task_t *next)
+{
+   taskext_t *ext = task_ext (prev) ;
+   schednode_t *node ;
+
+   // quem cedeu o processador ja foi contabilizado ao entrar no heap; quem
+   // se bloqueou deixa de disputar o processador
+   if (ext && prev != taskDisp && ext->sched.active && !ext->sched.queued) {
+      node = &ext->sched ;
+      stride_charge (node) ;
+      stride_tickets (node, ext) ;
+      stride_leave (node) ;
+   }
+   runStart = systime_ns () ;
+}
+
+static void stride_init ()
+{
+}
+
+static int stride_quantum (task_t *task)
+{
+   return (0) ;
+}
+
+const sched_ops_t sched_stride = {
+   .name      = "STRIDE",
+   .init      = stride_init,
+   .enqueue   = stride_enqueue,
+   .dequeue   = stride_dequeue,
+   .exit      = stride_exit,
+   .turn_end  = stride_turn_end,
+   .pick      = stride_pick,
+   .preempts  = stride_preempts,
+   .switch_to = stride_switch,
+   .quantum   = stride_quantum
+} ;
@@ -0,0 +1,220 @@
+// PingPongOS - PingPong Operating System
+
+// Escalonador por prioridades dinamicas, com custo O(1) por decisao
+// (PPOS_SCHED_PRIO, a politica padrao).
+//
+// A fila de prontas do nucleo (readyQueue) continua existindo; este modulo
+// mantem em paralelo um indice das mesmas tarefas, atualizado pelos hooks
+// que as colocam ou retiram de readyQueue. O indice tem uma fila FIFO por
+// nivel de prioridade dinamica (-20 a +20) e um mapa de bits dos niveis
+// nao vazios: a proxima tarefa e a primeira do nivel indicado pelo bit
+// menos significativo ligado.
+//
+// Envelhecimento: quando a tarefa em execucao termina a sua vez (task_yield
+// ou task_exit), as tarefas que continuam prontas sobem um nivel na proxima
+// decisao; uma tarefa que se bloqueia (join, semaforo...) nao envelhece as
+// demais. Em vez de mover as tarefas, os niveis giram sobre um vetor
+// circular e so os dois niveis do topo sao concatenados, pois a prioridade
+// dinamica nao passa de -20. Cada no guarda o seu nivel absoluto (nivel na
+// insercao + envelhecimentos ja feitos), de onde sai o nivel atual sem
+// percorrer filas. Uma tarefa escolhida volta mais tarde no nivel da sua
+// prioridade estatica.
+//
+// Empate no mesmo nivel: vence a menor prioridade estatica, que e a tarefa
+// que entrou por ultimo; entre as que entraram desde o ultimo
+// envelhecimento, vale a ordem de chegada. Com todas as tarefas na mesma
+// prioridade, o resultado e o mesmo da fila FIFO.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+#include "ppos-core-globals.h"
+
+#define SCHED_LEVELS 41			// prioridades -20 a +20
+
+static schednode_t *level[SCHED_LEVELS] ;	// filas, em vetor circular
+static schednode_t *fresh[SCHED_LEVELS] ;	// ultimo no inserido no nivel...
+static long freshAge[SCHED_LEVELS] ;		// ...desde este envelhecimento
+static long ages = 0 ;			// envelhecimentos ja feitos
+static unsigned long long bitmap = 0 ;	// bit n: nivel (n - 20) nao vazio
+static int turnEnded = 0 ;		// a ultima tarefa terminou a sua vez
+
+// fila fisica do nivel n (0 = prioridade -20)
+static schednode_t **prio_level (int n)
+{
+   return (&level[(ages + n) % SCHED_LEVELS]) ;
+}
+
+// insere o no no fim da fila circular *q
+static void node_append (schednode_t **q, schednode_t *node)
+{
+   if (!*q) {
+      node->prev = node->next = node ;
+      *q = node ;
+      return ;
+   }
+   node->prev = (*q)->prev ;
+   node->next = *q ;
+   (*q)->prev->next = node ;
+   (*q)->prev = node ;
+}
+
+// retira o no da fila circular *q
+static void node_remove (schednode_t **q, schednode_t *node)
+{
+   if (node->next == node)
+      *q = NULL ;
+   else {
+      node->prev->next = node->next ;
+      node->next->prev = node->prev ;
+      if (*q == node)
+         *q = node->next ;
+   }
+   node->prev = node->next = NULL ;
+}
+
+// tarefa entrou em readyQueue
+static void prio_enqueue (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+   schednode_t *node ;
+   int n, p ;
+
+   if (!ext || ext->sched.queued)
+      return ;
+   n = ext->prio + 20 ;
+   p = (ages + n) % SCHED_LEVELS ;
+   node = &ext->sched ;
+   node->task = task ;
+   node->key = ages + n ;
+   node->queued = 1 ;
+
+   // entra depois das que chegaram desde o ultimo envelhecimento e antes
+   // das que ja estavam no nivel (vindas de prioridades estaticas maiores)
+   if (fresh[p] && freshAge[p] == ages) {
+      schednode_t *after = fresh[p] ;
+      node->prev = after ;
+      node->next = after->next ;
+      after->next->prev = node ;
+      after->next = node ;
+   }
+   else {
+      node_append (&level[p], node) ;
+      level[p] = node ;
+   }
+   fresh[p] = node ;
+   freshAge[p] = ages ;
+   bitmap |= 1ULL << n ;
+}
+
+// retira o no da fila fisica p
+static void prio_remove (int p, schednode_t *node)
+{
+   // as que chegaram desde o ultimo envelhecimento ficam no inicio da fila
+   if (fresh[p] == node)
+      fresh[p] = (level[p] == node) ? NULL : node->prev ;
+   node_remove (&level[p], node) ;
+   node->queued = 0 ;
+}
+
+// tarefa saiu de readyQueue por outro caminho que nao prio_pick
+static void prio_dequeue (task_t *task)
+{
+   taskext_t *ext = task_ext (task) ;
+   int n, p ;
+
+   if (!ext || !ext->sched.queued)
+      return ;
+   // niveis abaixo de -20 foram concatenados no topo
+   n = ext->sched.key - ages ;
+   if (n < 0)
+      n = 0 ;
+   p = (ages + n) % SCHED_LEVELS ;
+   prio_remove (p, &ext->sched) ;
+   if (!level[p])
+      bitmap &= ~(1ULL << n) ;
+}
+
+static void prio_exit (task_t *task)
+{
+}
+
+// a tarefa corrente terminou a sua vez (task_yield ou task_exit)
+static void prio_turn_end ()
+{
+   turnEnded = 1 ;
+}
+
+// envelhece todas as tarefas prontas em um nivel
+static void prio_age ()
+{
+   schednode_t *top = *prio_level (0) ;
+   schednode_t **next = prio_level (1) ;
+
+   // o nivel -20 absorve o -19, mantendo as mais antigas na frente
+   if (top && *next) {
+      schednode_t *last = top->prev ;
+      top->prev = (*next)->prev ;
+      top->prev->next = top ;
+      last->next = *next ;
+      (*next)->prev = last ;
+      *next = top ;
+   }
+   else if (top)
+      *next = top ;
+   *prio_level (0) = NULL ;
+   ages++ ;
+   bitmap = (bitmap >> 1) | (bitmap & 1) ;
+}
+
+// escolhe e retira do indice a proxima tarefa a executar
+static task_t *prio_pick ()
+{
+   schednode_t *node ;
+   int n, p ;
+
+   if (!bitmap)
+      return (NULL) ;
+   n = __builtin_ctzll (bitmap) ;
+   p = (ages + n) % SCHED_LEVELS ;
+   node = level[p] ;
+   prio_remove (p, node) ;
+   if (!level[p])
+      bitmap &= ~(1ULL << n) ;
+   if (turnEnded)
+      prio_age () ;
+   turnEnded = 0 ;
+   return (node->task) ;
+}
+
+// as prioridades so valem nas decisoes do dispatcher
+static int prio_preempts (task_t *task)
+{
+   return (0) ;
+}
+
+static void prio_switch (task_t *prev, task_t *next)
+{
+}
+
+static void prio_init ()
+{
+}
+
+static int prio_quantum (task_t *task)
+{
+   return (0) ;
+}
+
+const sched_ops_t sched_prio = {
+   .name      = "PRIO",
+   .init      = prio_init,
+   .enqueue   = prio_enqueue,
+   .dequeue   = prio_dequeue,
+   .exit      = prio_exit,
+   .turn_end  = prio_turn_end,
+   .pick      = prio_pick,
+   .preempts  = prio_preempts,
+   .switch_to = prio_switch,
+   .quantum   = prio_quantum
+} ;
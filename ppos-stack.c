@@ -0,0 +1,322 @@
+// PingPongOS - PingPong Operating System
+
+// Pool de pilhas das tarefas.
+//
+// O nucleo aloca com malloc uma pilha de STACKSIZE bytes a cada task_create
+// e a libera quando a tarefa e recolhida pelo dispatcher. Com muitas tarefas
+// nascendo e morrendo isso pesa no malloc e no alocador de paginas. As
+// pilhas daqui sao mapeadas com mmap, tem uma pagina de guarda PROT_NONE
+// logo abaixo (um estouro gera SIGSEGV, reportado com o id da tarefa) e,
+// quando a tarefa termina, voltam para uma lista livre para reuso.
+//
+// Os tamanhos sao agrupados em classes (potencias de 2, de PPOS_STACK_MIN
+// a STACK_CLASS_MAX), cada uma com sua lista livre. As pilhas sao apenas
+// reservadas como memoria virtual (MAP_NORESERVE): uma pagina so ocupa RAM
+// quando a tarefa a toca, e ao voltar para o pool as paginas sao liberadas
+// com MADV_FREE. Assim um processo comporta centenas de milhares de
+// tarefas pouco ativas.
+//
+// Cada pilha com guarda ocupa dois mapeamentos de memoria e o Linux limita
+// esse numero por processo (vm.max_map_count, 65530 por padrao). Enquanto
+// houver pilhas mapeadas demais para esse limite, as novas sao criadas sem
+// guarda (com um aviso); pilhas sem guarda vizinhas sao fundidas pelo kernel
+// em um so mapeamento. Com PPOS_STACK_GUARD=0 no ambiente as paginas de
+// guarda sao sempre desligadas.
+//
+// Com PPOS_STACK_PAINT=1 no ambiente cada pilha e preenchida com um padrao
+// na criacao da tarefa e varrida quando ela termina, medindo o pico de uso;
+// um histograma de todas as tarefas e impresso ao fim do processo. A
+// pintura toca todas as paginas da pilha, entao so serve para medicao.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "ppos.h"
+#include "ppos-core-globals.h"
+#include "ppos-stack.h"
+
+// maior classe de tamanho mantida no pool; pilhas maiores vao direto ao SO
+#define STACK_CLASS_MAX (8 * 1024 * 1024)
+#define STACK_CLASSES   12
+
+// numero maximo de pilhas livres guardadas por classe
+#define STACK_POOL_MAX 256
+
+// mapeamentos deixados para o resto do processo (malloc, bibliotecas...)
+#define STACK_MAP_RESERVE 4096
+
+// padrao de pintura e numero de faixas do histograma (1 KiB a 8 MiB)
+#define STACK_PAINT_WORD  0xa5a5a5a5a5a5a5a5UL
+#define STACK_USAGE_SLOTS 14
+
+// tamanho da pilha alternativa usada pelo tratador de SIGSEGV
+#define STACK_GUARD_ALTSTACK 65536
+
+// pilha livre no pool; o no fica guardado na base da propria pilha. O topo
+// nao e tocado: o nucleo ainda retoma uma tarefa encerrada que ficou na
+// fila de prontas (p.ex. apos task_switch direto), e ela termina de
+// retornar sobre os quadros do topo da pilha.
+typedef struct freestack_t {
+   struct freestack_t *next ;
+} freestack_t ;
+
+static freestack_t *freeList[STACK_CLASSES] ;
+static long freeCount[STACK_CLASSES] ;
+static stackpool_stats_t stats ;
+static size_t pageSize = 0 ;
+static int guardEnabled = 1 ;
+static int guardWarned = 0 ;
+static long guardLimit ;	// pilhas mapeadas a partir das quais nao ha guarda
+static long mapped = 0 ;	// pilhas mapeadas (em uso ou no pool)
+
+static int paintEnabled = 0 ;
+static long usageHist[STACK_USAGE_SLOTS] ;
+static long usageTasks = 0 ;
+static size_t usageMax = 0 ;
+
+static void stack_usage_report () ;
+
+// escreve uma mensagem sem usar stdio (seguro dentro de tratador de sinal)
+static void guard_write (const char *msg, int value)
+{
+   char buf[16] ;
+   int i = sizeof (buf) ;
+   unsigned int v = (value < 0) ? -value : value ;
+
+   while (*msg)
+      if (write (STDERR_FILENO, msg++, 1) < 0)
+         return ;
+   do {
+      buf[--i] = '0' + v % 10 ;
+      v /= 10 ;
+   } while (v && i > 1) ;
+   if (value < 0)
+      buf[--i] = '-' ;
+   if (write (STDERR_FILENO, buf + i, sizeof (buf) - i) < 0)
+      return ;
+   if (write (STDERR_FILENO, "\n", 1) < 0)
+      return ;
+}
+
+// tratador de SIGSEGV: identifica acessos a pagina de guarda da tarefa
+// corrente. Como e instalado com SA_RESETHAND, ao retornar a instrucao e
+// repetida e o processo termina com a acao padrao do sinal.
+static void stack_guard_handler (int signum, siginfo_t *info, void *context)
+{
+   taskext_t *ext ;
+   uintptr_t addr = (uintptr_t) info->si_addr ;
+   uintptr_t base ;
+
+   if (!taskExec || !(ext = task_ext (taskExec)) || !ext->stack)
+      return ;
+
+   base = (uintptr_t) ext->stack ;
+   if (addr >= base - pageSize && addr < base)
+      guard_write ("PPOS: estouro de pilha na tarefa ", taskExec->id) ;
+}
+
+// instala o tratador de SIGSEGV em uma pilha alternativa, pois quando ele
+// dispara a pilha da tarefa ja esta esgotada
+static void stack_guard_init ()
+{
+   static char altstack[STACK_GUARD_ALTSTACK] ;
+   struct sigaction action ;
+   stack_t ss ;
+
+   ss.ss_sp = altstack ;
+   ss.ss_size = sizeof (altstack) ;
+   ss.ss_flags = 0 ;
+   if (sigaltstack (&ss, 0) < 0) {
+      perror ("Erro em sigaltstack") ;
+      return ;
+   }
+
+   action.sa_sigaction = stack_guard_handler ;
+   sigemptyset (&action.sa_mask) ;
+   action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESETHAND ;
+   if (sigaction (SIGSEGV, &action, 0) < 0)
+      perror ("Erro ao registrar tratador de estouro de pilha") ;
+}
+
+static void stack_init ()
+{
+   char *env = getenv ("PPOS_STACK_GUARD") ;
+   long maxMaps = 65530 ;
+   FILE *f ;
+
+   pageSize = sysconf (_SC_PAGESIZE) ;
+   if (env && strcmp (env, "0") == 0)
+      guardEnabled = 0 ;
+
+   // cada pilha com guarda conta no maximo dois mapeamentos
+   if ((f = fopen ("/proc/sys/vm/max_map_count", "r"))) {
+      if (fscanf (f, "%ld", &maxMaps) != 1)
+         maxMaps = 65530 ;
+      fclose (f) ;
+   }
+   guardLimit = (maxMaps - STACK_MAP_RESERVE) / 2 ;
+
+   env = getenv ("PPOS_STACK_PAINT") ;
+   if (env && strcmp (env, "1") == 0) {
+      paintEnabled = 1 ;
+      atexit (stack_usage_report) ;
+   }
+   if (guardEnabled)
+      stack_guard_init () ;
+}
+
+// classe de tamanho de size (ja arredondado), ou -1 se grande demais
+static int stack_class (size_t size)
+{
+   size_t s = PPOS_STACK_MIN ;
+   int c ;
+
+   for (c = 0; c < STACK_CLASSES && s <= STACK_CLASS_MAX; c++, s <<= 1)
+      if (size == s)
+         return (c) ;
+   return (-1) ;
+}
+
+// tamanho efetivo de uma pilha pedida com size bytes
+static size_t stack_round (size_t size)
+{
+   size_t s ;
+
+   if (size < PPOS_STACK_MIN)
+      size = PPOS_STACK_MIN ;
+   for (s = PPOS_STACK_MIN; s <= STACK_CLASS_MAX; s <<= 1)
+      if (size <= s)
+         return (s) ;
+   return ((size + pageSize - 1) & ~(pageSize - 1)) ;
+}
+
+void *stack_alloc (size_t *size)
+{
+   freestack_t *node ;
+   char *map ;
+   int c ;
+
+   if (!pageSize)
+      stack_init () ;
+
+   *size = stack_round (*size) ;
+   c = stack_class (*size) ;
+
+   if (c >= 0 && freeList[c]) {
+      node = freeList[c] ;
+      freeList[c] = node->next ;
+      freeCount[c]-- ;
+      stats.hits++ ;
+      stats.pooled-- ;
+      stats.inUse++ ;
+      return (node) ;
+   }
+
+   map = mmap (NULL, *size + pageSize, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_NORESERVE, -1, 0) ;
+   if (map == MAP_FAILED) {
+      perror ("Erro ao mapear pilha") ;
+      return (NULL) ;
+   }
+   if (guardEnabled && mapped < guardLimit) {
+      if (mprotect (map, pageSize, PROT_NONE) < 0)
+         perror ("Erro ao proteger pagina de guarda") ;
+   }
+   else if (guardEnabled && !guardWarned) {
+      fprintf (stderr, "PPOS: %ld pilhas mapeadas, novas pilhas sem pagina de guarda\n",
+               mapped) ;
+      guardWarned = 1 ;
+   }
+
+   mapped++ ;
+   stats.misses++ ;
+   stats.inUse++ ;
+   stats.reserved += *size + pageSize ;
+   return (map + pageSize) ;
+}
+
+void stack_release (void *stack, size_t size)
+{
+   freestack_t *node ;
+   int c ;
+
+   if (!stack)
+      return ;
+
+   stats.inUse-- ;
+   c = stack_class (size) ;
+   if (c >= 0 && freeCount[c] < STACK_POOL_MAX) {
+      // devolve ao SO as paginas ja tocadas, menos a do topo; a escrita do
+      // no mantem tambem a da base
+#ifdef MADV_FREE
+      madvise (stack, size - pageSize, MADV_FREE) ;
+#endif
+      node = stack ;
+      node->next = freeList[c] ;
+      freeList[c] = node ;
+      freeCount[c]++ ;
+      stats.pooled++ ;
+      return ;
+   }
+
+   munmap ((char *) stack - pageSize, size + pageSize) ;
+   mapped-- ;
+   stats.reserved -= size + pageSize ;
+}
+
+void stack_pool_stats (stackpool_stats_t *s)
+{
+   *s = stats ;
+}
+
+int stack_paint_enabled ()
+{
+   return (paintEnabled) ;
+}
+
+void stack_paint (void *stack, size_t size)
+{
+   uint64_t *p = stack ;
+   size_t i ;
+
+   for (i = 0; i < size / sizeof (uint64_t); i++)
+      p[i] = STACK_PAINT_WORD ;
+}
+
+size_t stack_peak (void *stack, size_t size)
+{
+   uint64_t *p = stack ;
+   size_t i, n = size / sizeof (uint64_t) ;
+   size_t peak, limit ;
+   int slot ;
+
+   // a pilha cresce para baixo: o primeiro valor alterado a partir da
+   // base marca o ponto mais fundo alcancado
+   for (i = 0; i < n && p[i] == STACK_PAINT_WORD; i++) ;
+   peak = (n - i) * sizeof (uint64_t) ;
+
+   for (slot = 0, limit = 1024; slot < STACK_USAGE_SLOTS - 1 && peak > limit;
+        slot++, limit <<= 1) ;
+   usageHist[slot]++ ;
+   usageTasks++ ;
+   if (peak > usageMax)
+      usageMax = peak ;
+   return (peak) ;
+}
+
+// histograma do pico de uso de pilha das tarefas encerradas
+static void stack_usage_report ()
+{
+   size_t limit ;
+   int slot ;
+
+   printf ("PPOS: uso maximo de pilha em %ld tarefas:\n", usageTasks) ;
+   for (slot = 0, limit = 1024; slot < STACK_USAGE_SLOTS; slot++, limit <<= 1)
+      if (usageHist[slot])
+         printf ("  ate %5ld KiB: %ld tarefas\n", (long) limit / 1024, usageHist[slot]) ;
+   printf ("  maior pico: %ld bytes\n", (long) usageMax) ;
+}
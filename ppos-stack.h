@@ -0,0 +1,40 @@
+// PingPongOS - PingPong Operating System
+
+// Pool de pilhas das tarefas (ver ppos-stack.c)
+
+#ifndef __PPOS_STACK__
+#define __PPOS_STACK__
+
+#include <stddef.h>
+
+// contadores do pool de pilhas
+typedef struct {
+   long hits ;		// pilhas atendidas por reciclagem
+   long misses ;	// pilhas que precisaram de um novo mmap
+   long inUse ;		// pilhas atualmente entregues a tarefas
+   long pooled ;	// pilhas livres guardadas no pool
+   size_t reserved ;	// memoria virtual mapeada, em bytes (pilhas + guardas)
+} stackpool_stats_t ;
+
+// obtem uma pilha de pelo menos *size bytes, protegida por uma pagina de
+// guarda abaixo dela; *size recebe o tamanho efetivo (arredondado para a
+// classe de tamanho). Retorna o endereco mais baixo da area utilizavel ou NULL.
+void *stack_alloc (size_t *size) ;
+
+// devolve ao pool uma pilha obtida com stack_alloc (size efetivo)
+void stack_release (void *stack, size_t size) ;
+
+// copia os contadores do pool para stats
+void stack_pool_stats (stackpool_stats_t *stats) ;
+
+// indica se as pilhas devem ser pintadas para medir o uso (PPOS_STACK_PAINT=1)
+int stack_paint_enabled () ;
+
+// preenche a pilha com o padrao de pintura (antes de preparar o contexto)
+void stack_paint (void *stack, size_t size) ;
+
+// retorna o pico de uso, em bytes, de uma pilha pintada, e o contabiliza
+// no histograma impresso ao fim do processo
+size_t stack_peak (void *stack, size_t size) ;
+
+#endif
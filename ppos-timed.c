@@ -0,0 +1,210 @@
+// PingPongOS - PingPong Operating System
+
+// Esperas com prazo: versoes de sem_down, mutex_lock, barrier_join,
+// mqueue_send/recv e task_join que desistem apos timeout ms.
+//
+// A tarefa se suspende na fila do objeto, como na operacao sem prazo do
+// nucleo, e arma o seu no da roda de tempo (ext->sleep, o mesmo de
+// task_sleep, pois ela nao pode dormir e esperar ao mesmo tempo) com um
+// registro de espera na propria pilha. Quem acorda a tarefa pelo caminho
+// normal (sem_up, mutex_unlock, task_exit...) usa task_resume, cujo hook
+// desarma o no; se o prazo vence antes, o dispatcher a retira da fila do
+// objeto com task_resume e desfaz a sua parte na contagem do objeto (o
+// valor do semaforo, as chegadas da barreira). As duas coisas ocorrem sem
+// preempcao, entao so uma delas acontece: nao ha despertar espurio, e
+// armar e desarmar o prazo custam O(1).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ppos.h"
+#include "ppos-core-globals.h"
+#include "ppos-wheel.h"
+
+// registro de espera com prazo (fica na pilha de quem espera)
+typedef struct
+{
+   task_t *task ;			// tarefa que aguarda
+   task_t **queue ;			// fila onde ela esta suspensa
+   int *count ;				// contador a corrigir no prazo, ou NULL
+   int undo ;				// correcao do contador
+   int expired ;			// 1 se o prazo venceu
+} timedwait_t ;
+
+// prazo vencido (no dispatcher): a tarefa deixa a fila do objeto
+static void timed_expire (wheelnode_t *node)
+{
+   timedwait_t *w = node->arg ;
+
+   if (w->task->queue != (task_t *) w->queue)
+      return ;
+   w->expired = 1 ;
+   if (w->count)
+      *w->count += w->undo ;
+   task_resume (w->task) ;
+}
+
+// suspende a tarefa corrente na fila queue por ate timeout ms; chamada sem
+// preempcao, que volta ao estado saved quando a tarefa retoma, como no
+// sem_down do nucleo. Retorna 1 se o prazo venceu
+static int timed_wait (task_t **queue, int *count, int undo, int timeout,
+                       unsigned char saved)
+{
+   taskext_t *ext = task_ext (taskExec) ;
+   unsigned int expires = systime () + timeout ;
+   timedwait_t w ;
+
+   w.task = taskExec ;
+   w.queue = queue ;
+   w.count = count ;
+   w.undo = undo ;
+   w.expired = 0 ;
+   ext->sleep.expire = timed_expire ;
+   ext->sleep.arg = &w ;
+   task_suspend (taskExec, queue) ;
+   wheel_add (&ext->sleep, expires) ;
+   tick_wake (expires) ;
+   task_yield () ;
+   preempt_restore (saved) ;
+   return (w.expired) ;
+}
+
+int sem_down_timed (semaphore_t *s, int timeout)
+{
+   unsigned char saved ;
+
+   if (timeout < 0)
+      return (sem_down (s)) ;
+   if (!s || !s->active || !task_ext (taskExec))
+      return (-1) ;
+
+   saved = preempt_save () ;
+   if (--s->value >= 0) {
+      preempt_restore (saved) ;
+      return (0) ;
+   }
+   if (!timeout) {
+      s->value++ ;
+      preempt_restore (saved) ;
+      return (PPOS_TIMEOUT) ;
+   }
+   if (timed_wait (&s->queue, &s->value, 1, timeout, saved))
+      return (PPOS_TIMEOUT) ;
+   return (s->active ? 0 : -1) ;
+}
+
+int mutex_lock_timed (mutex_t *m, int timeout)
+{
+   unsigned char saved ;
+
+   if (timeout < 0)
+      return (mutex_lock (m)) ;
+   if (!m || !m->active || !task_ext (taskExec))
+      return (-1) ;
+
+   // como no nucleo, mutex_unlock passa o mutex a tarefa que acorda
+   saved = preempt_save () ;
+   if (m->value) {
+      m->value = 0 ;
+      preempt_restore (saved) ;
+      return (0) ;
+   }
+   if (!timeout) {
+      preempt_restore (saved) ;
+      return (PPOS_TIMEOUT) ;
+   }
+   if (timed_wait (&m->queue, NULL, 0, timeout, saved))
+      return (PPOS_TIMEOUT) ;
+   return (m->active ? 0 : -1) ;
+}
+
+// a ultima tarefa a chegar libera as demais, como em barrier_join; quem
+// desiste deixa de contar como chegada
+int barrier_join_timed (barrier_t *b, int timeout)
+{
+   unsigned char saved ;
+
+   if (timeout < 0)
+      return (barrier_join (b)) ;
+   if (!b || !b->active || !task_ext (taskExec))
+      return (-1) ;
+
+   saved = preempt_save () ;
+   if (++b->countTasks == b->maxTasks) {
+      while (b->queue)
+         task_resume (b->queue) ;
+      b->countTasks = 0 ;
+      preempt_restore (saved) ;
+      return (0) ;
+   }
+   if (!timeout) {
+      b->countTasks-- ;
+      preempt_restore (saved) ;
+      return (PPOS_TIMEOUT) ;
+   }
+   if (timed_wait (&b->queue, &b->countTasks, -1, timeout, saved))
+      return (PPOS_TIMEOUT) ;
+   return (b->active ? 0 : -1) ;
+}
+
+// as filas de mensagens seguem mqueue_send/mqueue_recv do nucleo: vagas e
+// itens contados por semaforos, buffer protegido por outro
+int mqueue_send_timed (mqueue_t *queue, void *msg, int timeout)
+{
+   int status ;
+
+   if (!queue || !queue->active || !msg)
+      return (-1) ;
+   if ((status = sem_down_timed (&queue->sVaga, timeout)) < 0)
+      return (status) ;
+   if (sem_down (&queue->sBuffer) < 0)
+      return (-1) ;
+   memcpy ((char *) queue->content + queue->countMessages * queue->messageSize,
+           msg, queue->messageSize) ;
+   queue->countMessages++ ;
+   sem_up (&queue->sBuffer) ;
+   sem_up (&queue->sItem) ;
+   return (0) ;
+}
+
+int mqueue_recv_timed (mqueue_t *queue, void *msg, int timeout)
+{
+   int status ;
+
+   if (!queue || !queue->active || !msg)
+      return (-1) ;
+   if ((status = sem_down_timed (&queue->sItem, timeout)) < 0)
+      return (status) ;
+   if (sem_down (&queue->sBuffer) < 0)
+      return (-1) ;
+   memcpy (msg, queue->content, queue->messageSize) ;
+   queue->countMessages-- ;
+   memmove (queue->content, (char *) queue->content + queue->messageSize,
+            queue->countMessages * queue->messageSize) ;
+   sem_up (&queue->sBuffer) ;
+   sem_up (&queue->sVaga) ;
+   return (0) ;
+}
+
+int task_join_timed (task_t *task, int timeout)
+{
+   unsigned char saved ;
+
+   if (timeout < 0)
+      return (task_join (task)) ;
+   if (!task || !task_ext (taskExec))
+      return (-1) ;
+
+   saved = preempt_save () ;
+   if (task->state == 'x') {
+      preempt_restore (saved) ;
+      return (task->exitCode) ;
+   }
+   if (!timeout) {
+      preempt_restore (saved) ;
+      return (PPOS_TIMEOUT) ;
+   }
+   if (timed_wait (&task->joinQueue, NULL, 0, timeout, saved))
+      return (PPOS_TIMEOUT) ;
+   return (task->exitCode) ;
+}
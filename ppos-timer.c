@@ -0,0 +1,92 @@
+// PingPongOS - PingPong Operating System
+
+// Temporizadores de software: funcoes chamadas apos um prazo e, se
+// periodicos, a cada periodo, sem uma tarefa (e uma pilha) por temporizador.
+//
+// Cada temporizador e um no na roda de tempo (ppos-wheel.c), a mesma dos
+// despertares de task_sleep, entao armar e cancelar custam O(1). A roda e
+// avancada pelo dispatcher a cada passagem, e o tick retira o processador
+// da tarefa corrente quando ha um no vencido; as funcoes executam no
+// dispatcher, fora de qualquer tarefa, e nao podem bloquear.
+//
+// Um temporizador periodico e rearmado antes da chamada, a partir do prazo
+// anterior e nao do instante da expiracao, para nao acumular atraso; se o
+// dispatcher se atrasou mais de um periodo, os prazos perdidos sao pulados
+// e contados em overruns.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ppos.h"
+#include "ppos-core-globals.h"
+#include "ppos-wheel.h"
+
+static void timer_expire (wheelnode_t *node)
+{
+   swtimer_t *timer = node->arg ;
+   unsigned int now, next ;
+
+   if (timer->period) {
+      now = systime () ;
+      next = node->expires + timer->period ;
+      while ((int) (next - now) <= 0) {
+         next += timer->period ;
+         timer->overruns++ ;
+      }
+      wheel_add (node, next) ;
+   }
+   timer->fired++ ;
+   timer->func (timer->arg) ;
+}
+
+int timer_init (swtimer_t *timer, void (*func)(void *), void *arg)
+{
+   if (!timer || !func)
+      return (-1) ;
+   timer->node.prev = timer->node.next = NULL ;
+   timer->node.slot = 0 ;
+   timer->node.expire = timer_expire ;
+   timer->node.arg = timer ;
+   timer->func = func ;
+   timer->arg = arg ;
+   timer->period = 0 ;
+   timer->fired = 0 ;
+   timer->overruns = 0 ;
+   return (0) ;
+}
+
+int timer_start (swtimer_t *timer, int delay, int period)
+{
+   unsigned int expires ;
+   unsigned char old ;
+
+   if (!timer || timer->node.expire != timer_expire || delay < 0 || period < 0)
+      return (-1) ;
+
+   // tambem chamada pelas funcoes dos temporizadores, no dispatcher
+   old = preempt_save () ;
+   timer->period = period ;
+   expires = systime () + delay ;
+   wheel_add (&timer->node, expires) ;
+   preempt_restore (old) ;
+   tick_wake (expires) ;
+   return (0) ;
+}
+
+int timer_cancel (swtimer_t *timer)
+{
+   int armed ;
+   unsigned char old ;
+
+   if (!timer)
+      return (-1) ;
+   old = preempt_save () ;
+   armed = wheel_pending (&timer->node) ;
+   wheel_del (&timer->node) ;
+   preempt_restore (old) ;
+   return (armed ? 0 : -1) ;
+}
+
+int timer_pending (swtimer_t *timer)
+{
+   return (timer ? wheel_pending (&timer->node) : 0) ;
+}
@@ -0,0 +1,261 @@
+// PingPongOS - PingPong Operating System
+
+// Roda de tempo hierarquica (Varghese e Lauck) para os despertares de
+// task_sleep e os temporizadores de software (ppos-timer.c): armar e
+// desarmar um no custam O(1), e a expiracao custa O(1) amortizado por no,
+// em vez de percorrer todas as tarefas dormindo a cada passagem do
+// dispatcher.
+//
+// A roda tem WHEEL_LEVELS niveis de WHEEL_SIZE listas. O nivel 0 tem uma
+// lista por unidade de tempo; cada lista do nivel n cobre WHEEL_SIZE^n
+// unidades. Um no fica no nivel mais baixo que alcanca o seu instante, e os
+// alem do ultimo nivel ficam em uma lista de excedentes. Quando o tempo
+// chega ao inicio do intervalo coberto por uma lista de nivel n > 0, os
+// seus nos sao redistribuidos (cascata) pelos niveis de baixo, entao cada
+// no desce no maximo WHEEL_LEVELS vezes antes de expirar.
+//
+// Um mapa de bits por nivel indica as listas nao vazias, para que o avanco
+// salte os instantes sem nos e wheel_next encontre a proxima expiracao sem
+// percorrer as listas. Os instantes sao comparados pela diferenca com
+// sinal, entao a volta do contador de systime() nao afeta a ordem.
+
+#include <stdio.h>
+#include "ppos-wheel.h"
+
+#define WHEEL_BITS 6				// bits do indice em cada nivel
+#define WHEEL_SIZE (1 << WHEEL_BITS)		// listas por nivel
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4				// alcance de 2^24 unidades
+
+#define WHEEL_OVERFLOW (WHEEL_LEVELS * WHEEL_SIZE)	// alem do ultimo nivel
+#define WHEEL_LATE (WHEEL_OVERFLOW + 1)		// armados ja vencidos
+#define WHEEL_RUN (WHEEL_OVERFLOW + 2)		// expirando em wheel_advance
+#define WHEEL_LISTS (WHEEL_OVERFLOW + 3)
+
+static wheelnode_t *list[WHEEL_LISTS] ;		// filas circulares de nos
+static unsigned long long used[WHEEL_LEVELS] ;	// bit i: lista i nao vazia
+static unsigned int wheelTime = 0 ;		// proximo instante a processar
+static int armed = 0 ;				// nos armados
+static int expiring = 0 ;			// 1 ao expirar os nos de wheelTime
+
+// filas circulares com insercao no fim, como em queue.c, mas sem a busca
+// do elemento na remocao
+
+static void list_append (int pos, wheelnode_t *node)
+{
+   wheelnode_t *first = list[pos] ;
+
+   if (!first) {
+      node->prev = node->next = node ;
+      list[pos] = node ;
+      if (pos < WHEEL_OVERFLOW)
+         used[pos / WHEEL_SIZE] |= 1ULL << (pos & WHEEL_MASK) ;
+   }
+   else {
+      node->next = first ;
+      node->prev = first->prev ;
+      first->prev->next = node ;
+      first->prev = node ;
+   }
+   node->slot = pos + 1 ;
+}
+
+static void list_remove (wheelnode_t *node)
+{
+   int pos = node->slot - 1 ;
+
+   if (node->next == node) {
+      list[pos] = NULL ;
+      if (pos < WHEEL_OVERFLOW)
+         used[pos / WHEEL_SIZE] &= ~(1ULL << (pos & WHEEL_MASK)) ;
+   }
+   else {
+      node->prev->next = node->next ;
+      node->next->prev = node->prev ;
+      if (list[pos] == node)
+         list[pos] = node->next ;
+   }
+   node->prev = node->next = NULL ;
+   node->slot = 0 ;
+}
+
+// coloca o no na lista que cobre o seu instante, em relacao a wheelTime
+static void wheel_place (wheelnode_t *node)
+{
+   int delta = (int) (node->expires - wheelTime) ;
+   int level ;
+
+   // a lista de wheelTime ja foi coletada se os seus nos estao expirando
+   if (delta < 0 || (delta == 0 && expiring)) {
+      list_append (WHEEL_LATE, node) ;
+      return ;
+   }
+   for (level = 0; level < WHEEL_LEVELS; level++)
+      if (delta < 1 << (WHEEL_BITS * (level + 1))) {
+         list_append (level * WHEEL_SIZE +
+                      ((node->expires >> (WHEEL_BITS * level)) & WHEEL_MASK), node) ;
+         return ;
+      }
+   list_append (WHEEL_OVERFLOW, node) ;
+}
+
+// redistribui os nos da lista pos a partir de wheelTime
+static void wheel_cascade (int pos)
+{
+   wheelnode_t *node ;
+
+   while ((node = list[pos])) {
+      list_remove (node) ;
+      wheel_place (node) ;
+   }
+}
+
+// passa os nos da lista pos para a lista dos que vao expirar
+static void wheel_collect (int pos)
+{
+   wheelnode_t *node ;
+
+   while ((node = list[pos])) {
+      list_remove (node) ;
+      list_append (WHEEL_RUN, node) ;
+   }
+}
+
+// expira os nos coletados; os rearmados nas funcoes expire vao para as
+// listas normais e ficam para a proxima passagem
+static void wheel_run ()
+{
+   wheelnode_t *node ;
+
+   while ((node = list[WHEEL_RUN])) {
+      list_remove (node) ;
+      armed-- ;
+      node->expire (node) ;
+   }
+}
+
+void wheel_init (unsigned int now)
+{
+   int i ;
+
+   for (i = 0; i < WHEEL_LISTS; i++)
+      list[i] = NULL ;
+   for (i = 0; i < WHEEL_LEVELS; i++)
+      used[i] = 0 ;
+   wheelTime = now ;
+   armed = 0 ;
+}
+
+void wheel_add (wheelnode_t *node, unsigned int expires)
+{
+   if (node->slot)
+      list_remove (node) ;
+   else
+      armed++ ;
+   node->expires = expires ;
+   wheel_place (node) ;
+}
+
+void wheel_del (wheelnode_t *node)
+{
+   if (!node->slot)
+      return ;
+   list_remove (node) ;
+   armed-- ;
+}
+
+int wheel_pending (wheelnode_t *node)
+{
+   return (node->slot != 0) ;
+}
+
+void wheel_advance (unsigned int now)
+{
+   unsigned long long later ;
+   unsigned int step ;
+   int level, index ;
+
+   wheel_collect (WHEEL_LATE) ;
+   wheel_run () ;
+   if (!armed) {
+      wheelTime = now + 1 ;
+      return ;
+   }
+
+   while ((int) (now - wheelTime) >= 0) {
+      index = wheelTime & WHEEL_MASK ;
+
+      // inicio de um bloco do nivel 0: desce a lista correspondente de cada
+      // nivel cujo bloco tambem comeca aqui, e os excedentes na volta toda
+      for (level = 1; level <= WHEEL_LEVELS && !(wheelTime &
+           ((1U << (WHEEL_BITS * level)) - 1)); level++)
+         if (level < WHEEL_LEVELS)
+            wheel_cascade (level * WHEEL_SIZE +
+                           ((wheelTime >> (WHEEL_BITS * level)) & WHEEL_MASK)) ;
+         else
+            wheel_cascade (WHEEL_OVERFLOW) ;
+
+      wheel_collect (index) ;
+      expiring = 1 ;
+      wheel_run () ;
+      expiring = 0 ;
+
+      // salta ate a proxima lista nao vazia do bloco, ou ate o fim dele
+      later = used[0] & ~((2ULL << index) - 1) ;
+      step = later ? __builtin_ctzll (later) - index : WHEEL_SIZE - index ;
+      if (step > now - wheelTime)
+         step = now - wheelTime + 1 ;
+      wheelTime += step ;
+   }
+}
+
+int wheel_next (unsigned int *when)
+{
+   unsigned int best = 0, t, base ;
+   int level, index, k, found = 0 ;
+
+   if (!armed)
+      return (0) ;
+   if (list[WHEEL_LATE]) {
+      *when = wheelTime - 1 ;
+      return (1) ;
+   }
+
+   // nivel 0: instante exato, no bloco corrente ou no seguinte
+   index = wheelTime & WHEEL_MASK ;
+   base = wheelTime - index ;
+   if (used[0] & ~((1ULL << index) - 1)) {
+      best = base + __builtin_ctzll (used[0] & ~((1ULL << index) - 1)) ;
+      found = 1 ;
+   }
+   else if (used[0]) {
+      best = base + WHEEL_SIZE + __builtin_ctzll (used[0]) ;
+      found = 1 ;
+   }
+
+   // niveis acima: o inicio da proxima cascata com nos, que nao passa da
+   // expiracao deles
+   for (level = 1; level < WHEEL_LEVELS; level++) {
+      if (!used[level])
+         continue ;
+      base = wheelTime >> (WHEEL_BITS * level) ;
+      index = base & WHEEL_MASK ;
+      k = (wheelTime & ((1U << (WHEEL_BITS * level)) - 1)) ? 1 : 0 ;
+      for (; k <= WHEEL_SIZE; k++)
+         if (used[level] & (1ULL << ((index + k) & WHEEL_MASK)))
+            break ;
+      t = (base + k) << (WHEEL_BITS * level) ;
+      if (!found || (int) (t - best) < 0)
+         best = t ;
+      found = 1 ;
+   }
+   if (list[WHEEL_OVERFLOW]) {
+      t = ((wheelTime >> (WHEEL_BITS * WHEEL_LEVELS)) + 1) <<
+          (WHEEL_BITS * WHEEL_LEVELS) ;
+      if (!found || (int) (t - best) < 0)
+         best = t ;
+      found = 1 ;
+   }
+   *when = best ;
+   return (found) ;
+}
@@ -0,0 +1,32 @@
+// PingPongOS - PingPong Operating System
+
+// Roda de tempo hierarquica dos despertares e temporizadores (ver ppos-wheel.c)
+
+#ifndef __PPOS_WHEEL__
+#define __PPOS_WHEEL__
+
+#include "ppos-data.h"
+
+// esvazia a roda, que passa a contar o tempo a partir do instante now
+void wheel_init (unsigned int now) ;
+
+// arma o no para expirar no instante expires (em unidades de systime); um
+// no ja armado e movido. Um instante ja passado expira no proximo
+// wheel_advance. node->expire e node->arg devem estar preenchidos.
+void wheel_add (wheelnode_t *node, unsigned int expires) ;
+
+// desarma o no; nada faz se ele nao estiver armado
+void wheel_del (wheelnode_t *node) ;
+
+// indica se o no esta armado
+int wheel_pending (wheelnode_t *node) ;
+
+// expira os nos com instante ate now: cada um e desarmado e so entao sua
+// funcao expire e chamada, que pode rearma-lo
+void wheel_advance (unsigned int now) ;
+
+// se ha nos armados, coloca em *when um instante que nao passa da proxima
+// expiracao e retorna 1; senao retorna 0
+int wheel_next (unsigned int *when) ;
+
+#endif
@@ -19,10 +19,14 @@
 #warning Este codigo foi planejado para ambientes UNIX (LInux, *BSD, MacOS). A compilacao e execucao em outros ambientes e responsabilidade do usuario.
 #endif
 
-// otimizações podem atrapalhar código que manipula contexto
-#ifdef __OPTIMIZE__
-#error "Please do not use optimizations (-O1, -O2, ...)"
-#endif
+// O nucleo (ppos-all.o) ja vem compilado; o restante do sistema e as
+// aplicacoes podem ser compilados com otimizacoes (-O1, -O2, ...); o
+// script pingpong-O2.sh compila os testes com -O2 e compara as saidas.
+// Barreira de compilacao: o compilador nao move acessos a memoria atraves
+// dela nem reaproveita valores lidos antes. Deve separar o codigo que
+// depende de estado alterado por outra tarefa ou por um tratador de sinal;
+// esse estado tambem deve ser volatile.
+#define PPOS_BARRIER __asm__ __volatile__ ("" ::: "memory")
 
 #include "ppos-data.h"		// estruturas de dados necessárias
 
@@ -62,6 +66,36 @@ void before_task_create (task_t *task );
 void after_task_create (task_t *task );  // Após o retorno dessa funcao, a nova tarefa é incluída na
                                          // fila de tarefas prontas.
 
+// preenche attr com os valores padrao (pilha de STACKSIZE, prioridade 0,
+// sem nome, sem grupo)
+void task_attr_init (task_attr_t *attr) ;
+
+// Cria uma nova tarefa com os atributos indicados (attr pode ser NULL).
+// Retorna um ID> 0 ou erro.
+int task_create_attr (task_t *task,			// descritor da nova tarefa
+                      void (*start_func)(void *),	// funcao corpo da tarefa
+                      void *arg,			// argumentos para a tarefa
+                      const task_attr_t *attr) ;	// atributos da tarefa
+
+// retorna o nome de uma tarefa (ou da tarefa atual), ou NULL se nao tiver
+const char *task_getname (task_t *task) ;
+
+// armazenamento local de tarefa: cada chave indexa um valor proprio de cada
+// tarefa, inicialmente NULL. Ao termino da tarefa (task_exit) o destrutor
+// da chave, se houver, e chamado para cada valor nao nulo.
+
+// aloca uma chave em *key; retorna 0 ou -1 se todas estiverem em uso
+int task_key_create (int *key, void (*destructor)(void *)) ;
+
+// libera a chave (sem chamar destrutores) e descarta os valores das tarefas;
+// retorna 0 ou -1 se invalida
+int task_key_delete (int key) ;
+
+// define/retorna o valor da tarefa corrente para a chave; com chave
+// invalida ou livre, set retorna -1 e get retorna NULL
+int task_setspecific (int key, void *value) ;
+void *task_getspecific (int key) ;
+
 // Termina a tarefa corrente, indicando um valor de status encerramento
 void task_exit (int exitCode) ;
 void before_task_exit ();
@@ -102,9 +136,50 @@ void task_setprio (task_t *task, int prio) ;
 // retorna a prioridade estática de uma tarefa (ou a tarefa atual)
 int task_getprio (task_t *task) ;
 
+// define o tempo de execucao estimado de uma tarefa (ou a tarefa atual);
+// com a politica SRTF, a tarefa pode receber o processador imediatamente
+void task_set_eet (task_t *task, int et) ;
+
+// retorna o tempo de execucao estimado de uma tarefa (ou a tarefa atual)
+int task_get_eet (task_t *task) ;
+
+// retorna o tempo de execucao restante (estimado - consumido) de uma tarefa
+// (ou a tarefa atual)
+int task_get_ret (task_t *task) ;
+
+// define os bilhetes de uma tarefa (ou a tarefa atual), no minimo 1; com a
+// politica STRIDE, cada tarefa recebe o processador na proporcao dos seus
+// bilhetes sobre os das tarefas que o disputam
+void task_set_tickets (task_t *task, int tickets) ;
+
+// retorna os bilhetes de uma tarefa (ou a tarefa atual)
+int task_get_tickets (task_t *task) ;
+
+// torna a tarefa (ou a tarefa atual) periodica, na classe de tempo real EDF,
+// que executa antes das tarefas comuns: a cada period ms e liberado um
+// trabalho que usa ate budget ms de processador e deve terminar em deadline
+// ms (0 = period). Com period 0 a tarefa volta a ser comum. Retorna 0, ou -1
+// se os parametros forem invalidos ou se a admissao falhar (a soma de
+// budget / min (deadline, period) das tarefas periodicas passaria de
+// PPOS_RT_CAPACITY por cento)
+int task_set_rt (task_t *task, int period, int budget, int deadline) ;
+
+// conclui o trabalho corrente da tarefa periodica e aguarda a liberacao do
+// proximo; retorna 0, ou -1 se a tarefa atual nao for periodica
+int task_rt_wait () ;
+
+// retorna os trabalhos concluidos por uma tarefa (ou a tarefa atual), e
+// quantos deles terminaram apos o prazo
+int task_rt_jobs (task_t *task) ;
+int task_rt_misses (task_t *task) ;
+
 // retorna a proxima tarefa a ser executada conforme a politica de escalonamento
 task_t * scheduler() ;
 
+// retorna o nome da politica de escalonamento em uso (ver PPOS_CPU_SCHED),
+// ou EDF se houver tarefas periodicas (task_set_rt)
+const char *ppos_sched_name () ;
+
 // operações de gestão do tempo ================================================
 
 // suspende a tarefa corrente por t milissegundos
@@ -116,6 +191,39 @@ void after_task_sleep () ;
 // retorna o valor atual do relógio do sistema (em milisegundos)
 unsigned int systime () ;
 
+// relogio monotonico de alta resolucao, em ns e em us desde o ppos_init (0
+// antes dele); nao volta a zero e le o relogio do vDSO, sem chamada de
+// sistema, entao pode ser usado a cada troca de contexto
+unsigned long long systime_ns () ;
+unsigned long long systime_us () ;
+
+// temporizadores de software: nao ha uma tarefa por temporizador; as
+// funcoes executam no dispatcher, que o tick chama quando ha expiracoes
+// vencidas, e por isso nao podem bloquear (sem_down, task_sleep,
+// task_join...). Retornam 0 ou -1 em caso de erro
+
+// inicializa um temporizador desarmado que chama func (arg)
+int timer_init (swtimer_t *timer, void (*func)(void *), void *arg) ;
+
+// arma (ou rearma) o temporizador para expirar daqui a delay ms e, se
+// period > 0, a cada period ms depois disso. Um temporizador atrasado mais
+// de um periodo nao repete as chamadas perdidas; elas sao contadas em
+// timer->overruns
+int timer_start (swtimer_t *timer, int delay, int period) ;
+
+// desarma o temporizador; retorna -1 se ele nao estava armado
+int timer_cancel (swtimer_t *timer) ;
+
+// 1 se o temporizador esta armado, 0 se nao
+int timer_pending (swtimer_t *timer) ;
+
+// ocupacao do processador desde o ppos_init, em ms: tempo decorrido (wall),
+// tempo em que o dispatcher ficou ocioso, sem tarefas prontas (idle), e
+// processador consumido pelo processo (cpu); ponteiros NULL sao ignorados.
+// O dispatcher ocioso bloqueia o processo ate o proximo sinal ou despertar;
+// com PPOS_IDLE_SPIN=1 ele gira, e cpu inclui o tempo ocioso
+void ppos_idle_stats (unsigned int *wall, unsigned int *idle, unsigned int *cpu) ;
+
 // operações de sincronização ==================================================
 
 // a tarefa corrente aguarda o encerramento de outra task
@@ -169,6 +277,55 @@ int mutex_destroy (mutex_t *m) ;
 int before_mutex_destroy (mutex_t *m) ;
 int after_mutex_destroy (mutex_t *m) ;
 
+// futuros
+
+// inicializa um futuro ainda nao concluido
+int future_create (future_t *f) ;
+
+// conclui o futuro com o resultado indicado, acordando as tarefas que o
+// aguardam; retorna -1 se ele ja estava concluido
+int future_complete (future_t *f, int result) ;
+
+// conclui o futuro com o codigo de saida da tarefa quando ela terminar
+int future_task (future_t *f, task_t *task) ;
+
+// retorna 1 se o futuro ja foi concluido, 0 se nao
+int future_done (future_t *f) ;
+
+// aguarda a conclusao do futuro e retorna o seu resultado
+int future_await (future_t *f) ;
+
+// aguarda a conclusao de pelo menos um dos n futuros; retorna o indice de
+// um futuro concluido
+int future_await_any (future_t **f, int n) ;
+
+// aguarda a conclusao de todos os n futuros; retorna 0
+int future_await_all (future_t **f, int n) ;
+
+// grupos de tarefas
+
+// inicializa um grupo vazio
+int group_create (task_group_t *g) ;
+
+// cria uma tarefa como membro do grupo (como task_create_attr com
+// attr.group = g). Retorna um ID> 0 ou erro.
+int group_task_create (task_group_t *g, task_t *task,
+                       void (*start_func)(void *), void *arg) ;
+
+// aguarda o termino de todos os membros do grupo; a tarefa e acordada uma
+// unica vez, pelo ultimo membro a terminar. Retorna o status agregado
+// (primeiro codigo de saida nao nulo, ou 0) ou -1 se o grupo for invalido
+int group_join (task_group_t *g) ;
+
+// destroi o grupo; retorna -1 se ainda houver membros em execucao
+int group_destroy (task_group_t *g) ;
+
+// passagem direta: com enable != 0, sem_up e mutex_unlock entregam o
+// processador imediatamente a tarefa que acordaram, sem passar pelo
+// dispatcher; a tarefa corrente volta ao fim da fila de prontas.
+// Retorna o modo anterior (inicial: variavel de ambiente PPOS_HANDOFF=1)
+int ppos_handoff (int enable) ;
+
 // barreiras
 
 // Inicializa uma barreira
@@ -213,6 +370,20 @@ int mqueue_msgs (mqueue_t *queue) ;
 int before_mqueue_msgs (mqueue_t *queue) ;
 int after_mqueue_msgs (mqueue_t *queue) ;
 
+// esperas com prazo
+
+// como as operacoes sem prazo, mas desistem apos timeout ms e retornam
+// PPOS_TIMEOUT; timeout 0 so tenta a operacao, e timeout < 0 espera sem
+// prazo. task_join_timed retorna o codigo de saida da tarefa, que entao nao
+// deve ser PPOS_TIMEOUT para ser distinguido
+#define PPOS_TIMEOUT (-2)
+int sem_down_timed (semaphore_t *s, int timeout) ;
+int mutex_lock_timed (mutex_t *m, int timeout) ;
+int barrier_join_timed (barrier_t *b, int timeout) ;
+int mqueue_send_timed (mqueue_t *queue, void *msg, int timeout) ;
+int mqueue_recv_timed (mqueue_t *queue, void *msg, int timeout) ;
+int task_join_timed (task_t *task, int timeout) ;
+
 // funcao para debug. imprime os campos da estrutura task_t
 void print_tcb( task_t* task );
 
@@ -285,11 +456,48 @@ void print_tcb( task_t* task );
 #define PPOS_TASK_STATE_TERMINATED 'T'
 
 #define STACKSIZE              32768
+#define PPOS_DEFAULT_EET       99999	// tempo estimado de tarefas sem task_set_eet
+#define PPOS_DEFAULT_TICKETS   100	// bilhetes de tarefas sem task_set_tickets
+
+// politicas de escalonamento do processador: todas sao compiladas e uma e
+// escolhida no ppos_init pelo nome na variavel de ambiente PPOS_CPU_SCHED
+// (FIFO, PRIO, SRTF, CFS, MLFQ ou STRIDE); sem ela, vale a politica padrao, que pode
+// ser trocada na compilacao com -DPPOS_CPU_SCHED=PPOS_SCHED_...
+// Com PPOS_SCHED_REPORT=1 no ambiente, o STRIDE e a classe EDF imprimem um
+// relatorio de cada tarefa no task_exit
+#define PPOS_SCHED_FIFO        0	// ordem de chegada em readyQueue
+#define PPOS_SCHED_PRIO        1	// prioridades dinamicas (ppos-sched.c)
+#define PPOS_SCHED_SRTF        2	// menor tempo restante (ppos-sched-srtf.c)
+#define PPOS_SCHED_CFS         3	// tempo virtual justo (ppos-sched-cfs.c)
+#define PPOS_SCHED_MLFQ        4	// filas multinivel com realimentacao
+					// (ppos-sched-mlfq.c); configurada no
+					// ppos_init pelas variaveis de ambiente
+					// PPOS_MLFQ_LEVELS, PPOS_MLFQ_QUANTUM (ms)
+					// e PPOS_MLFQ_BOOST (ms)
+#define PPOS_SCHED_STRIDE      5	// divisao proporcional aos bilhetes
+					// (ppos-sched-stride.c)
+#ifndef PPOS_CPU_SCHED
+#define PPOS_CPU_SCHED         PPOS_SCHED_PRIO
+#endif
+#define PPOS_STACK_MIN         16384	// menor pilha aceita por task_create_attr;
+					// cabe o quadro de um sinal (o tick) com
+					// o estado estendido do processador
+#ifndef PPOS_QUANTUM
+#define PPOS_QUANTUM           20	// quantum padrao da preempcao por tempo
+					// (ms); no ppos_init, a variavel de
+					// ambiente PPOS_QUANTUM o substitui (0
+					// desliga a preempcao) e PPOS_TICKLESS=1
+					// troca o tick de 1 ms por disparos unicos
+					// no fim de cada quantum
+#endif
+#ifndef PPOS_RT_CAPACITY
+#define PPOS_RT_CAPACITY       100	// processador admitido em tempo real (%)
+#endif
 
 #define PRINT_READY_QUEUE      queue_print ("Ready Queue", (queue_t*)readyQueue, (void*)&print_tcb );
 
-#define PPOS_PREEMPT_ENABLE  preemption = 1;
-#define PPOS_PREEMPT_DISABLE preemption = 0;
+#define PPOS_PREEMPT_ENABLE  PPOS_BARRIER; preemption = 1; PPOS_BARRIER;
+#define PPOS_PREEMPT_DISABLE PPOS_BARRIER; preemption = 0; PPOS_BARRIER;
 #define PPOS_IS_PREEMPT_ACTIVE (preemption == 1)
 
 #endif